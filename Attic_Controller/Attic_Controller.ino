@@ -19,6 +19,8 @@
 #include <WiFiUdp.h>           //OTA
 #include <ArduinoOTA.h>        //OTA
 #include "Attic_Controller.h"  //Functions
+#include "OTAHelper.h"         //Compressed / Delta OTA
+#include "LogHelper.h"         //Logging
 #include "Options.cpp"         //User Options
 extern "C" {
   #include "user_interface.h"
@@ -46,6 +48,7 @@ void setup() {
   WiFi.mode(WIFI_STA);
   initWifi();
   initOTA();
+  OTA_Helper.setup(UPDATE_NAME);
   
   dht.begin();
 }
@@ -54,6 +57,9 @@ void setup() {
 void loop() {
   checkTempHumid();
   checkSerial();
+  ArduinoOTA.handle();
+  OTA_Helper.checkForUpdate();
+  Log_Helper.loop();
   yield();
   delay(100); //saves considerable power & heat
 }
@@ -70,12 +76,12 @@ void initWifi() {
   // Connect to WiFi
   WiFi.begin(WIFI_SSID, WIFI_PASS);
   while (WiFi.waitForConnectResult() != WL_CONNECTED) {
-    Serial.println("Connection Failed! Rebooting...");
+    LOG_ERROR("WIFI", "Connection Failed! Rebooting...");
+    Log_Helper.flush();
     delay(5000);
     ESP.restart();
   }
-  Serial.println("");
-  Serial.println("WiFi connected");
+  LOG_INFO("WIFI", "WiFi connected");
 }
 
 //Start OTA
@@ -92,26 +98,27 @@ void initOTA() {
     }
 
     // NOTE: if updating FS this would be the place to unmount FS using FS.end()
-    Serial.println("Start updating " + type);
+    LOG_INFO("OTA", "Start updating %s", type.c_str());
   });
   ArduinoOTA.onEnd([]() {
-    Serial.println("\nEnd");
+    LOG_INFO("OTA", "End");
+    Log_Helper.flush();
   });
   ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
-    Serial.printf("Progress: %u%%\r", (progress / (total / 100)));
+    LOG_DEBUG("OTA", "Progress: %u%%", (progress / (total / 100)));
   });
   ArduinoOTA.onError([](ota_error_t error) {
-    Serial.printf("Error[%u]: ", error);
     if (error == OTA_AUTH_ERROR) {
-      Serial.println("Auth Failed");
+      LOG_ERROR("OTA", "Error[%u]: Auth Failed", (unsigned)error);
     } else if (error == OTA_BEGIN_ERROR) {
-      Serial.println("Begin Failed");
+      LOG_ERROR("OTA", "Error[%u]: Begin Failed", (unsigned)error);
+      OTA_Helper.cancel(); // Our own unfinished download holds the updater, so the next push can have it
     } else if (error == OTA_CONNECT_ERROR) {
-      Serial.println("Connect Failed");
+      LOG_ERROR("OTA", "Error[%u]: Connect Failed", (unsigned)error);
     } else if (error == OTA_RECEIVE_ERROR) {
-      Serial.println("Receive Failed");
+      LOG_ERROR("OTA", "Error[%u]: Receive Failed", (unsigned)error);
     } else if (error == OTA_END_ERROR) {
-      Serial.println("End Failed");
+      LOG_ERROR("OTA", "Error[%u]: End Failed", (unsigned)error);
     }
   });
   ArduinoOTA.begin();
@@ -129,8 +136,8 @@ void checkTempHumid() {
 
     HTTPClient http;
     http.begin("http://10.0.0.21:8086/write?db=sensors");
-    http.POST("weather,location=ATTIC Temperature=" + String(temp) + ",Humidity=" + String(humid));
-    http.writeToStream(&Serial);
+    int code = http.POST("weather,location=ATTIC Temperature=" + String(temp) + ",Humidity=" + String(humid));
+    LOG_DEBUG("HTTP", "POST returned %d", code);
     http.end();
     lastTempHumidSend = millis();
   }
@@ -192,40 +199,48 @@ void handleSerial() {
   if (serialChars[0] == 'W') {
     HTTPClient http;
     http.begin("http://10.0.0.21:8086/write?db=sensors");
-    http.POST("weather,location=ROOF WindSpeed=" + String(stringChars));
-    http.writeToStream(&Serial);
+    int code = http.POST("weather,location=ROOF WindSpeed=" + String(stringChars));
+    LOG_DEBUG("HTTP", "POST returned %d", code);
     http.end();
   }
   //Temperature Update
   if (serialChars[0] == 'T') {
     HTTPClient http;
     http.begin("http://10.0.0.21:8086/write?db=sensors");
-    http.POST("weather,location=ROOF Temperature=" + String(stringChars));
-    http.writeToStream(&Serial);
+    int code = http.POST("weather,location=ROOF Temperature=" + String(stringChars));
+    LOG_DEBUG("HTTP", "POST returned %d", code);
     http.end();
   }
   //Humidity Update
   if (serialChars[0] == 'H') {
     HTTPClient http;
     http.begin("http://10.0.0.21:8086/write?db=sensors");
-    http.POST("weather,location=ROOF Humidity=" + String(stringChars));
-    http.writeToStream(&Serial);
+    int code = http.POST("weather,location=ROOF Humidity=" + String(stringChars));
+    LOG_DEBUG("HTTP", "POST returned %d", code);
     http.end();
   }
   //'Battery' Update
   if (serialChars[0] == 'B') {
     HTTPClient http;
     http.begin("http://10.0.0.21:8086/write?db=sensors");
-    http.POST("weather,location=ROOF Battery=" + String(stringChars));
-    http.writeToStream(&Serial);
+    int code = http.POST("weather,location=ROOF Battery=" + String(stringChars));
+    LOG_DEBUG("HTTP", "POST returned %d", code);
+    http.end();
+  }
+  //Time the roof sensor spent awake in the last hour
+  if (serialChars[0] == 'A') {
+    HTTPClient http;
+    http.begin("http://10.0.0.21:8086/write?db=sensors");
+    int code = http.POST("weather,location=ROOF AwakeTime=" + String(stringChars));
+    LOG_DEBUG("HTTP", "POST returned %d", code);
     http.end();
   }
   //Rain Flip
   if (serialChars[0] == 'R') {
     HTTPClient http;
     http.begin("http://10.0.0.21:8086/write?db=sensors");
-    http.POST("weather,location=ROOF RainFlip=" + String(1));
-    http.writeToStream(&Serial);
+    int code = http.POST("weather,location=ROOF RainFlip=" + String(1));
+    LOG_DEBUG("HTTP", "POST returned %d", code);
     http.end();
   }
 }
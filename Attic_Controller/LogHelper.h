@@ -0,0 +1,96 @@
+//----------------------------------------------------------------------------------------------------------------
+// LogHelper.h
+//
+// Buffered, leveled logging.  Lines are formatted into a ring buffer, and drained a little at a time from the
+// main loop, so logging never blocks waiting on the UART.  Levels above LOG_LEVEL are compiled out, and their
+// arguments are never evaluated.  For ease, we define a global object that can be used for all logging.
+//
+// Use the macros, with a short tag for the module doing the logging:
+//   LOG_INFO("MQTT", "connected to %s", host);
+//
+// Author - Joshua Villwock
+// Created - 2026-10-19
+// License - Mozilla Public License 2.0 (Do what you want, credit the author, must release under same license)
+//----------------------------------------------------------------------------------------------------------------
+
+#ifndef __LogHelper_H__
+#define __LogHelper_H__
+
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#define LOG_SINK_SERIAL 1
+#define LOG_SINK_UDP    2
+
+//---------------------------------------------------------//
+//              CONFIGURE YOUR LOGGING HERE                //
+//---------------------------------------------------------//
+#define LOG_LEVEL       LOG_LEVEL_WARN  // Anything more verbose is compiled out.  Our UART is the roof sensor link
+#define LOG_SINK        LOG_SINK_SERIAL // Where lines are drained to
+#define LOG_UDP_HOST    IPAddress(10, 0, 0, 21)
+#define LOG_UDP_PORT    5140
+#define LOG_BUFFER_SIZE 1024            // Bytes waiting to be drained.  More than this and lines are dropped
+#define LOG_LINE_SIZE   128             // Longer lines are cut short
+//---------------------------------------------------------//
+
+// Type-checks the arguments against the format, but never evaluates them.  Keeps disabled levels warning-free
+// for variables only they read, and catches bad formats, since the PSTR() copy can't be checked directly.
+#define LOG_CHECK(format, ...) if (0) Log_Helper.log(0, "", format, ##__VA_ARGS__)
+#define LOG_WRITE(level, tag, format, ...) \
+  do { LOG_CHECK(format, ##__VA_ARGS__); Log_Helper.log(level, tag, PSTR(format), ##__VA_ARGS__); } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(tag, format, ...) LOG_WRITE(LOG_LEVEL_ERROR, tag, format, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(tag, format, ...) do { LOG_CHECK(format, ##__VA_ARGS__); } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(tag, format, ...)  LOG_WRITE(LOG_LEVEL_WARN, tag, format, ##__VA_ARGS__)
+#else
+#define LOG_WARN(tag, format, ...)  do { LOG_CHECK(format, ##__VA_ARGS__); } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(tag, format, ...)  LOG_WRITE(LOG_LEVEL_INFO, tag, format, ##__VA_ARGS__)
+#else
+#define LOG_INFO(tag, format, ...)  do { LOG_CHECK(format, ##__VA_ARGS__); } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(tag, format, ...) LOG_WRITE(LOG_LEVEL_DEBUG, tag, format, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(tag, format, ...) do { LOG_CHECK(format, ##__VA_ARGS__); } while (0)
+#endif
+
+class LogHelper
+{
+  char buffer[LOG_BUFFER_SIZE];
+  size_t head;                   // where the next byte is written
+  size_t tail;                   // where the next byte is drained from
+  size_t used;
+  unsigned long dropped;         // lines thrown away because the buffer was full
+  unsigned long droppedReported;
+#if LOG_SINK == LOG_SINK_UDP
+  WiFiUDP udp;
+#endif
+
+  bool push(const char* data, size_t len);
+  void consume(size_t len);
+
+public:
+  void log(byte level, const char* tag, const char* format, ...) __attribute__((format(printf, 4, 5)));
+  void loop();
+  void flush();
+  unsigned long getDropped();
+};
+
+extern LogHelper Log_Helper;
+
+#endif //__LogHelper_H__
@@ -18,5 +18,8 @@
 //Name of the device.  Both for DHCP name & OTA Name
 #define DEVICE_NAME  "ESP_EIDOLON_IPMI"
 
+//Where this node finds its firmware on the update server.  Must be unique to this sketch
+#define UPDATE_NAME  "Attic_Controller"
+
 //What pin is the DHT connect to?
 const int DHTPin = 2;
@@ -22,6 +22,8 @@
 #include <ArduinoOTA.h>        //OTA
 #include <ESP8266HTTPClient.h> //Server
 #include <ESP8266WebServer.h>  //Server
+#include "OTAHelper.h"         //Compressed / Delta OTA
+#include "LogHelper.h"         //Logging
 #include <lwip/netif.h>        //GratuitousARP
 #include <lwip/etharp.h>       //GratuitousARP
 #include "Options.cpp"         //User Options
@@ -48,9 +50,10 @@ char temp[8] =             "";
 
 void setup() {
   Serial.begin(115200);
-  Serial.println("Booting");
+  LOG_INFO("MAIN", "Booting");
   initWifi();
   initOTA();
+  OTA_Helper.setup(UPDATE_NAME);
   dht.begin();
 
   server.on("/", getStatus);
@@ -63,13 +66,15 @@ void setup() {
   pinMode(POWER_LED,    INPUT);  //Connected to 'hot' wire of power LED (resistor?)
 
   server.begin(); //Start the server
-  Serial.println("Server listening");
+  LOG_INFO("MAIN", "Server listening");
 }
 
 void loop() {
   //Handle any incoming requests
   server.handleClient();
   ArduinoOTA.handle();
+  OTA_Helper.checkForUpdate();
+  Log_Helper.loop();
 
   // Check for system power off state
   if (millis() > lastPowerCheck + POWER_CHECK_FREQUENCY) {
@@ -112,19 +117,19 @@ void initWifi() {
   // Connect to WiFi
   WiFi.begin(WIFI_SSID, WIFI_PASS);
   while (WiFi.waitForConnectResult() != WL_CONNECTED) {
-    Serial.println("Connection Failed! Rebooting...");
+    LOG_ERROR("WIFI", "Connection Failed! Rebooting...");
+    Log_Helper.flush();
     delay(5000);
     ESP.restart();
   }
-  Serial.println("");
-  Serial.println("WiFi connected");
+  LOG_INFO("WIFI", "WiFi connected");
 
   // Start the server
   server.begin();
-  Serial.println("Server started");
+  LOG_INFO("MAIN", "Server started");
 
   // Print the IP address
-  Serial.println(WiFi.localIP());
+  LOG_INFO("WIFI", "IP address: %s", WiFi.localIP().toString().c_str());
 }
 
 //Start OTA
@@ -141,26 +146,27 @@ void initOTA() {
     }
 
     // NOTE: if updating FS this would be the place to unmount FS using FS.end()
-    Serial.println("Start updating " + type);
+    LOG_INFO("OTA", "Start updating %s", type.c_str());
   });
   ArduinoOTA.onEnd([]() {
-    Serial.println("\nEnd");
+    LOG_INFO("OTA", "End");
+    Log_Helper.flush();
   });
   ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
-    Serial.printf("Progress: %u%%\r", (progress / (total / 100)));
+    LOG_DEBUG("OTA", "Progress: %u%%", (progress / (total / 100)));
   });
   ArduinoOTA.onError([](ota_error_t error) {
-    Serial.printf("Error[%u]: ", error);
     if (error == OTA_AUTH_ERROR) {
-      Serial.println("Auth Failed");
+      LOG_ERROR("OTA", "Error[%u]: Auth Failed", (unsigned)error);
     } else if (error == OTA_BEGIN_ERROR) {
-      Serial.println("Begin Failed");
+      LOG_ERROR("OTA", "Error[%u]: Begin Failed", (unsigned)error);
+      OTA_Helper.cancel(); // Our own unfinished download holds the updater, so the next push can have it
     } else if (error == OTA_CONNECT_ERROR) {
-      Serial.println("Connect Failed");
+      LOG_ERROR("OTA", "Error[%u]: Connect Failed", (unsigned)error);
     } else if (error == OTA_RECEIVE_ERROR) {
-      Serial.println("Receive Failed");
+      LOG_ERROR("OTA", "Error[%u]: Receive Failed", (unsigned)error);
     } else if (error == OTA_END_ERROR) {
-      Serial.println("End Failed");
+      LOG_ERROR("OTA", "Error[%u]: End Failed", (unsigned)error);
     }
   });
   ArduinoOTA.begin();
@@ -232,15 +238,14 @@ void checkTempHumid() {
   float bob = getTemperature();
   dtostrf(getTemperature(), -6, 2, temp); // Leave room for too large numbers!
 
-  Serial.print("temp: ");
-  Serial.println(temp);
+  LOG_INFO("DHT", "temp: %s", temp);
   sendTempUpdate();
 }
 
 void sendTempUpdate() {
   HTTPClient http;
   http.begin("http://10.0.0.21:8086/write?db=sensors");
-  http.POST("weather,location=PLAYHOUSE Temperature=" + String(temp));
-  http.writeToStream(&Serial);
+  int code = http.POST("weather,location=PLAYHOUSE Temperature=" + String(temp));
+  LOG_DEBUG("HTTP", "POST returned %d", code);
   http.end();
 }
@@ -0,0 +1,377 @@
+//----------------------------------------------------------------------------------------------------------------
+// OTAHelper.cpp
+//
+// Pulls firmware updates over HTTP, as either a gzip-compressed image or a delta against the running firmware.
+// Interrupted downloads resume where they left off, and every image is MD5 checked before it is booted.
+// For ease, we define a global object that can be used for all update-related functions
+//
+// The update server is just static files, as written by tools/ota_delta.py:
+//   <update name>/manifest.txt        "target <md5>" and "full <md5>" lines
+//   <update name>/<running md5>.hdlt  delta from that firmware to the target
+//   <update name>/firmware.bin.gz     full compressed image, used when there is no matching delta
+//
+// Author - Joshua Villwock
+// Created - 2026-10-19
+// License - Mozilla Public License 2.0 (Do what you want, credit the author, must release under same license)
+//----------------------------------------------------------------------------------------------------------------
+
+#include "OTAHelper.h"
+#include "LogHelper.h"
+
+//---------------------------------------------------------//
+//           CONFIGURE YOUR UPDATE SERVER HERE             //
+//---------------------------------------------------------//
+const char          UPDATE_SERVER[] = "http://10.0.0.21/firmware/";
+const unsigned long UPDATE_CHECK_FREQUENCY  = 3600000;     // Check hourly
+const unsigned long UPDATE_RESUME_FREQUENCY = 60000;       // Check this often while a download is unfinished
+const int           UPDATE_RETRIES          = 5;           // Reconnects per check.  Past that we resume next check
+const unsigned long UPDATE_STALL_TIME       = 10000;       // Reconnect if no data for this long
+//---------------------------------------------------------//
+
+// Delta decoder states
+#define DELTA_HEADER  0
+#define DELTA_OP      1
+#define DELTA_ARGS    2
+#define DELTA_LITERAL 3
+#define DELTA_DONE    4
+
+// Delta opcodes
+#define OP_END  0x00 // no arguments
+#define OP_COPY 0x01 // u32 offset, u32 length: copy from the running firmware
+#define OP_DATA 0x02 // u32 length, then that many literal bytes
+
+// fetch() results
+#define FETCH_DONE    0 // installed, ready to reboot into
+#define FETCH_MISSING 1 // nothing usable there: no such file, or a delta for other firmware
+#define FETCH_FAILED  2 // the transfer or the updater failed, so the same file is worth trying again later
+
+#define DELTA_HEADER_SIZE 48 // "HDLT", version, 3 reserved, base size, base md5, target size, target md5
+
+OTAHelper OTA_Helper = OTAHelper();
+
+static uint32_t readLE32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static String toHex(const uint8_t* p, size_t len) {
+  const char digits[] = "0123456789abcdef";
+  String result;
+  for (size_t i = 0; i < len; i++) {
+    result += digits[p[i] >> 4];
+    result += digits[p[i] & 0x0f];
+  }
+  return result;
+}
+
+// Finds the value of a "key value" line in the manifest
+static String manifestValue(const String& manifest, const char* key) {
+  String find = String(key) + " ";
+  int start = manifest.indexOf(find);
+  if (start < 0) {
+    return "";
+  }
+  start += find.length();
+  int end = manifest.indexOf('\n', start);
+  if (end < 0) {
+    end = manifest.length();
+  }
+  String value = manifest.substring(start, end);
+  value.trim();
+  return value;
+}
+
+// Remembers which update directory is ours.  Each node needs its own, even when two share a hostname.
+void OTAHelper::setup(const char* name) {
+  updateName = name;
+  lastUpdateCheck = millis();
+}
+
+// Needs to be called by the main program loop frequently.
+// Checks for an update, but only if it hasn't checked in the last UPDATE_CHECK_FREQUENCY ms...
+// (or UPDATE_RESUME_FREQUENCY ms, when there is a download to finish)
+void OTAHelper::checkForUpdate() {
+  unsigned long frequency = partialURL.length() > 0 ? UPDATE_RESUME_FREQUENCY : UPDATE_CHECK_FREQUENCY;
+  if (millis() > lastUpdateCheck + frequency) {
+    update();
+    lastUpdateCheck = millis();
+  }
+}
+
+// Installs newer firmware from the server, if there is any.
+// Prefers a delta against the running firmware, falling back to the full compressed image only when there is no
+// usable delta.  If the delta transfer itself fails, we try it again at the next check rather than fetching
+// the much bigger full image over the same bad link.
+// On success we reboot into the new firmware, so this only returns when nothing was installed.
+bool OTAHelper::update() {
+  String target, full;
+  if (!readManifest(target, full)) {
+    return false;
+  }
+
+  String running = ESP.getSketchMD5();
+  if (target == running) {
+    cancel();
+    return false;
+  }
+
+  LOG_INFO("OTA", "Updating firmware %s -> %s", running.c_str(), target.c_str());
+  String base    = String(UPDATE_SERVER) + updateName + "/";
+  String fullURL = base + "firmware.bin.gz";
+  byte   result  = FETCH_MISSING;
+  if (partialURL != fullURL || targetMD5 != full) { // An unfinished full image just carries on
+    result = fetch(base + running + ".hdlt", true, target);
+  }
+  if (result == FETCH_MISSING) {
+    result = fetch(fullURL, false, full);
+  }
+  if (result == FETCH_DONE) {
+    LOG_INFO("OTA", "Update complete, rebooting");
+    Log_Helper.flush();
+    ESP.restart();
+    return true;
+  }
+  LOG_WARN("OTA", "Update failed");
+  return false;
+}
+
+// Reads the target firmware MD5, and the MD5 of the compressed image, from the manifest
+bool OTAHelper::readManifest(String& target, String& full) {
+  HTTPClient http;
+  http.begin(String(UPDATE_SERVER) + updateName + "/manifest.txt");
+  if (http.GET() != HTTP_CODE_OK) {
+    http.end();
+    return false;
+  }
+  String manifest = http.getString();
+  http.end();
+
+  target = manifestValue(manifest, "target");
+  full   = manifestValue(manifest, "full");
+  return target.length() == 32 && full.length() == 32;
+}
+
+// Throws away any unfinished download, freeing the updater for ArduinoOTA
+void OTAHelper::cancel() {
+  if (Update.isRunning()) {
+    Update.end(); // Not finished, so this just throws it away
+  }
+  partialURL = "";
+}
+
+// Downloads url into the update partition.
+// If the connection drops or stalls, we reconnect and ask for just the rest with a Range request.
+// If it still isn't done after UPDATE_RETRIES, the update is left open, and the next call for the same url
+// and md5 carries on from there.  The delta decoder keeps its state too, so it picks up exactly where it stopped.
+byte OTAHelper::fetch(const String& url, bool isDelta, const String& md5) {
+  if (url != partialURL || md5 != targetMD5) { // A different file, or the manifest moved on
+    cancel();
+    partialURL = url;
+    delta      = isDelta;
+    targetMD5  = md5;
+    state      = DELTA_HEADER;
+    argsHave   = 0;
+    argsNeed   = DELTA_HEADER_SIZE;
+    total      = -1;
+    received   = 0;
+  } else {
+    LOG_INFO("OTA", "Resuming download at %lu bytes", (unsigned long)received);
+  }
+
+  uint8_t buf[512];
+  byte    failure = FETCH_FAILED;
+
+  for (int attempt = 0; attempt < UPDATE_RETRIES && (total < 0 || received < (uint32_t)total); attempt++) {
+    HTTPClient http;
+    http.begin(url);
+    if (received > 0) {
+      http.addHeader("Range", "bytes=" + String(received) + "-");
+    }
+
+    int code = http.GET();
+    if (code == HTTP_CODE_NOT_FOUND) { // Nothing there, so no point retrying
+      http.end();
+      failure = FETCH_MISSING;
+      break;
+    }
+    if (code != HTTP_CODE_OK && code != HTTP_CODE_PARTIAL_CONTENT) {
+      http.end();
+      delay(1000);
+      continue;
+    }
+
+    // A plain 200 means the server ignored our Range, so skip what we already have
+    uint32_t skip = 0;
+    if (code == HTTP_CODE_OK) {
+      skip  = received;
+      total = http.getSize();
+      if (total <= 0) {
+        http.end();
+        break;
+      }
+    }
+
+    // Full images go straight to the updater, which checks the MD5 of exactly what we write
+    if (!delta && !Update.isRunning()) {
+      if (!Update.begin(total)) {
+        LOG_ERROR("OTA", "Updater error %u", (unsigned)Update.getError());
+        http.end();
+        break;
+      }
+      Update.setMD5(targetMD5.c_str());
+    }
+
+    WiFiClient* stream = http.getStreamPtr();
+    unsigned long lastData = millis();
+    while (received < (uint32_t)total && (http.connected() || stream->available())) {
+      size_t avail = stream->available();
+      if (avail == 0) {
+        if (millis() - lastData > UPDATE_STALL_TIME) {
+          break;
+        }
+        delay(1);
+        continue;
+      }
+
+      size_t n = stream->readBytes(buf, min(avail, sizeof(buf)));
+      size_t s = min((size_t)skip, n);
+      skip    -= s;
+      lastData = millis();
+      if (!feed(buf + s, n - s)) {
+        http.end();
+        cancel();
+        // A delta turned away by its header is no use to us, anything later is a failed transfer
+        return (delta && state == DELTA_HEADER) ? FETCH_MISSING : FETCH_FAILED;
+      }
+      received += n - s;
+    }
+    http.end();
+
+    if (received < (uint32_t)total) {
+      LOG_WARN("OTA", "Update interrupted at %lu bytes, resuming", (unsigned long)received);
+    }
+  }
+
+  if (failure == FETCH_FAILED && total > 0 && received > 0 && received < (uint32_t)total) {
+    LOG_WARN("OTA", "Download unfinished at %lu of %d bytes, resuming next check", (unsigned long)received, total);
+    return FETCH_FAILED;
+  }
+  if (total < 0 || received < (uint32_t)total || (delta && state != DELTA_DONE)) {
+    cancel();
+    return failure;
+  }
+  partialURL = "";
+  if (!Update.end()) {
+    LOG_ERROR("OTA", "Updater error %u", (unsigned)Update.getError());
+    return FETCH_FAILED;
+  }
+  return FETCH_DONE;
+}
+
+// Passes downloaded bytes on to the updater, decoding them first if this is a delta.
+bool OTAHelper::feed(uint8_t* data, size_t len) {
+  if (!delta) {
+    return Update.write(data, len) == len;
+  }
+
+  size_t i = 0;
+  while (i < len) {
+    if (state == DELTA_HEADER || state == DELTA_ARGS) {
+      size_t n = min(len - i, argsNeed - argsHave);
+      memcpy(args + argsHave, data + i, n);
+      argsHave += n;
+      i += n;
+      if (argsHave == argsNeed && !handleArgs()) {
+        return false;
+      }
+    } else if (state == DELTA_OP) {
+      op = data[i++];
+      argsHave = 0;
+      if (op == OP_END) {
+        state = DELTA_DONE;
+      } else if (op == OP_COPY) {
+        argsNeed = 8;
+        state = DELTA_ARGS;
+      } else if (op == OP_DATA) {
+        argsNeed = 4;
+        state = DELTA_ARGS;
+      } else {
+        LOG_ERROR("OTA", "Bad delta opcode");
+        return false;
+      }
+    } else if (state == DELTA_LITERAL) {
+      size_t n = min(len - i, (size_t)literalLeft);
+      if (Update.write(data + i, n) != n) {
+        return false;
+      }
+      literalLeft -= n;
+      i += n;
+      if (literalLeft == 0) {
+        state = DELTA_OP;
+      }
+    } else {
+      return false; // Data after the end marker
+    }
+  }
+  return true;
+}
+
+// Acts on a completely received delta header or opcode argument block
+bool OTAHelper::handleArgs() {
+  if (state == DELTA_HEADER) {
+    if (memcmp(args, "HDLT", 4) != 0 || args[4] != 1) {
+      LOG_ERROR("OTA", "Bad delta header");
+      return false;
+    }
+    if (readLE32(args + 8) != ESP.getSketchSize() || toHex(args + 12, 16) != ESP.getSketchMD5()) {
+      LOG_WARN("OTA", "Delta is for different firmware");
+      return false;
+    }
+    if (toHex(args + 32, 16) != targetMD5) {
+      LOG_WARN("OTA", "Delta does not match manifest");
+      return false;
+    }
+    if (!Update.begin(readLE32(args + 28))) {
+      LOG_ERROR("OTA", "Updater error %u", (unsigned)Update.getError());
+      return false;
+    }
+    Update.setMD5(targetMD5.c_str());
+    state = DELTA_OP;
+    return true;
+  }
+
+  if (op == OP_COPY) {
+    if (!copyFromBase(readLE32(args), readLE32(args + 4))) {
+      return false;
+    }
+    state = DELTA_OP;
+  } else {
+    literalLeft = readLE32(args);
+    state = (literalLeft > 0) ? DELTA_LITERAL : DELTA_OP;
+  }
+  return true;
+}
+
+// Copies len bytes of the running firmware, starting at offset, into the update.
+// flashRead() needs 4-byte alignment, so we read aligned words and only write out the part we want.
+bool OTAHelper::copyFromBase(uint32_t offset, uint32_t len) {
+  if (offset + len < offset || offset + len > ESP.getSketchSize()) {
+    LOG_ERROR("OTA", "Bad delta copy");
+    return false;
+  }
+
+  uint32_t words[64];
+  while (len > 0) {
+    uint32_t aligned = offset & ~3;
+    uint32_t skip    = offset - aligned;
+    uint32_t n       = min(len, (uint32_t)sizeof(words) - skip);
+    if (!ESP.flashRead(aligned, words, (skip + n + 3) & ~3)) {
+      return false;
+    }
+    if (Update.write((uint8_t*)words + skip, n) != n) {
+      return false;
+    }
+    offset += n;
+    len    -= n;
+  }
+  return true;
+}
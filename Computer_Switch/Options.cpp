@@ -14,6 +14,9 @@
 //Name of the device.  Both for DHCP name & OTA Name
 #define DEVICE_NAME  "ESP_EIDOLON_IPMI"
 
+//Where this node finds its firmware on the update server.  Must be unique to this sketch
+#define UPDATE_NAME  "Computer_Switch"
+
 //Which pins are connected?
 #define RELAY_PIN    D1
 #define POWER_BUTTON D4
@@ -17,6 +17,7 @@
 #include <ESP8266HTTPClient.h>
 #include "Options.cpp"
 #include "MQTTHelper.h"
+#include "LogHelper.h"
 extern "C" {
   #include "user_interface.h"
 }
@@ -39,7 +40,7 @@ WiFiClientSecure wifiClient;
 void setup() {
   Serial.begin(9600);
   while(!Serial) { }         // Wait for serial to initialize.
-  Serial.println("I AM WOKE.");
+  LOG_INFO("MAIN", "I AM WOKE.");
   
   dht.begin();
   connectWifi();
@@ -54,7 +55,8 @@ void setup() {
 void loop() {
   delay(1000);  //Sometimes the MQTT doesn't seem to go through before sleep begins....
   yield();
-  Serial.println("Going into deep sleep for 5 minutes");
+  LOG_INFO("MAIN", "Going into deep sleep for %d seconds", UPDATE_FREQUENCY);
+  Log_Helper.flush();
   ESP.deepSleep(UPDATE_FREQUENCY * 1000000);
 }
 
@@ -70,24 +72,21 @@ void connectWifi() {
   unsigned long wifiConnectStart = millis();
   
   WiFi.begin(WIFI_SSID, WIFI_PASS);
-  Serial.print("Connecting wifi");
+  LOG_INFO("WIFI", "Connecting");
   while (WiFi.status() != WL_CONNECTED) {
     if (WiFi.status() == WL_CONNECT_FAILED) {
-      Serial.println("Failed to connect to WiFi. Please verify credentials: ");
+      LOG_ERROR("WIFI", "Failed to connect. Please verify credentials");
       delay(10000);
     }
 
     delay(500);
-    Serial.print(".");
     // Only try for 5 seconds.
     if (millis() - wifiConnectStart > 15000) {
-      Serial.println("Failed to connect to WiFi");
+      LOG_WARN("WIFI", "Failed to connect");
       return;
     }
   }
-  Serial.println("");
-  Serial.print("IP address: ");
-  Serial.println(WiFi.localIP());
+  LOG_INFO("WIFI", "IP address: %s", WiFi.localIP().toString().c_str());
 }
 
 
@@ -101,15 +100,14 @@ float getHumidity() {
 
 // Send temp / humidity update
 void checkTempHumid() {
-  Serial.println("Checking temp...");
+  LOG_DEBUG("DHT", "Checking temp...");
   char temp[8]; // Buffer big enough for 7-character float
   dtostrf(getTemperature(), -6, 2, temp); // Leave room for too large numbers!
 
   char humid[8];
   dtostrf(getHumidity(), -6, 2, humid);
 
-  Serial.println(temp);
-  Serial.println(humid);
+  LOG_INFO("DHT", "temp %s humid %s", temp, humid);
   MQTT_Helper.publishMQTT("home/living/micro/temp",  temp,  false);
   MQTT_Helper.publishMQTT("home/living/micro/humid", humid, false);
 }
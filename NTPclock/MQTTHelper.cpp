@@ -10,6 +10,7 @@
 //----------------------------------------------------------------------------------------------------------------
 
 #include "MQTTHelper.h"
+#include "LogHelper.h"
 #include "LEDHelper.h"
 
 //---------------------------------------------------------//
@@ -41,19 +42,17 @@ void MQTTHelper::connect() {
 // Tries to reconnect MQTT, but only if it hasn't tried in the last MQTT_RECONNECT_TIME seconds...
 void MQTTHelper::reconnect() {
   if (millis() > lastMQTTReconnect + MQTT_RECONNECT_TIME) {
-    Serial.print("Attempting MQTT connection...");
+    LOG_INFO("MQTT", "Attempting connection...");
     // Create a random client ID
     String clientId = "ESP8266Client-";
     clientId += String(random(0xffff), HEX);
     // Attempt to connect
     if (mqttClient.connect(clientId.c_str())) {
-      Serial.println("connected");
+      LOG_INFO("MQTT", "connected");
       // ... and resubscribe
       mqttClient.subscribe("home/jroom/clock/brightness", 1);
     } else {
-      Serial.print("failed, rc=");
-      Serial.print(mqttClient.state());
-      Serial.println(" try again in MQTT_RECONNECT_TIME seconds");
+      LOG_WARN("MQTT", "failed, rc=%d, try again in %d ms", mqttClient.state(), MQTT_RECONNECT_TIME);
     }
     lastMQTTReconnect = millis();
   }
@@ -84,8 +83,7 @@ void MQTTHelper::MQTTCallback(char* topic, byte* payload, unsigned int length) {
   String topicString = String(topic);     //the topic is null-terminated, so we can easily convert it.
   int    msgInt      = msgString.toInt(); //the int version of the message, if conversion is possible.
 
-  Serial.println("Topic:" + topicString);
-  Serial.println("Payload: " + msgString);
+  LOG_DEBUG("MQTT", "%s: %s", topic, message_buff);
 
   if (topicString.equalsIgnoreCase("home/jroom/clock/brightness")) {
     LED_Helper.set_brightness(msgInt);
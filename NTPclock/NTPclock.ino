@@ -14,6 +14,7 @@
 #include "LEDHelper.h"
 #include "TimeManager.h"
 #include "MQTTHelper.h"
+#include "LogHelper.h"
 #include "Options.cpp"
 extern "C" {
   #include "user_interface.h"
@@ -31,7 +32,6 @@ unsigned long lastTempSend = millis();
 // Initial set up routines
 void setup() {
   Serial.begin(9600);
-  Serial.println();
 
   LED_Helper.LED_Setup();     //Turn on the LEDS, etc.
 
@@ -48,14 +48,14 @@ void loop() {
   yield();
   checkTimeUpdate();
   checkTempUpdate();
+  Log_Helper.loop();
   delay(50); //saves considerable power & heat
 }
 
 // Initial connection to WiFi
 // We wait for 5 seconds to connect, but do not block on the connection.
 void connectWifi() {
-  Serial.print("Connecting to ");
-  Serial.println(WIFI_SSID);
+  LOG_INFO("WIFI", "Connecting to %s", WIFI_SSID);
   WiFi.begin(WIFI_SSID, WIFI_PASS);
   delay(5000);
 }
@@ -66,7 +66,7 @@ void checkTimeUpdate() {
     LED_Helper.updateDigits(); //Update the time display
     LED_Helper.updateMisc();   //Update the rest of the display
 
-    Serial.println(NTP.getTimeDateString() );
+    LOG_DEBUG("CLOCK", "%s", NTP.getTimeDateString().c_str());
 
     displayLastUpdated = millis();
   }
@@ -11,6 +11,7 @@
 
 #include "TimeManager.h"
 #include "LEDHelper.h"
+#include "LogHelper.h"
 
 #include <DS3232RTC.h>    // RTC Library
 #include <TimeLib.h>      // Must be included AFTER DS3232RTC!!!
@@ -28,20 +29,18 @@ void TimeManager::RTCSetup() {
 
 // Initial set up of NTP
 void TimeManager::beginNTP() {
-  Serial.print("Starting NTP client...");
   NTP.begin("pool.ntp.org", -8, true);    //-8 is pacific time, true means dst
   NTP.setInterval(86400);                 //every 24 hours
 
   //Called on NTP update.
   NTP.onNTPSyncEvent([](NTPSyncEvent_t ntpEvent) {
     if (ntpEvent == 0) {
-      Serial.print(NTP.getTimeDateString(NTP.getLastNTPSync()));
-      Serial.println(" NTP UPDATE!");
+      LOG_INFO("NTP", "%s NTP UPDATE!", NTP.getTimeDateString(NTP.getLastNTPSync()).c_str());
       RTC.set(NTP.getLastNTPSync());
     }
   });
 
-  Serial.println("Done.");
+  LOG_INFO("NTP", "Client started");
 }
 
 // Enables or Disables military time
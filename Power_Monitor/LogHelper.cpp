@@ -0,0 +1,123 @@
+//----------------------------------------------------------------------------------------------------------------
+// LogHelper.cpp
+//
+// Buffered, leveled logging.  Lines are formatted into a ring buffer, and drained a little at a time from the
+// main loop, so logging never blocks waiting on the UART.
+// For ease, we define a global object that can be used for all logging.
+//
+// Author - Joshua Villwock
+// Created - 2026-10-19
+// License - Mozilla Public License 2.0 (Do what you want, credit the author, must release under same license)
+//----------------------------------------------------------------------------------------------------------------
+
+#include "LogHelper.h"
+
+#define LOG_UDP_LINES_PER_LOOP 4 // Packets sent per call to loop()
+
+static const char LEVEL_CHARS[] = "-EWID"; // One letter per level, for the start of each line
+
+LogHelper Log_Helper = LogHelper();
+
+// Formats a line and queues it to be drained.  Use the LOG_* macros rather than calling this directly.
+// The format string is expected to be in flash (PSTR), which the macros take care of.
+void LogHelper::log(byte level, const char* tag, const char* format, ...) {
+  char line[LOG_LINE_SIZE];
+  snprintf(line, sizeof(line), "%lu %c %s: ", millis(), LEVEL_CHARS[level], tag);
+
+  size_t len = strlen(line);
+  va_list args;
+  va_start(args, format);
+  vsnprintf_P(line + len, sizeof(line) - len, format, args);
+  va_end(args);
+
+  len = strlen(line);
+  if (len > sizeof(line) - 2) {
+    len = sizeof(line) - 2;
+  }
+  line[len++] = '\n';
+
+  // Let whoever is reading know they missed something, as soon as there is room to say so
+  if (dropped != droppedReported) {
+    char notice[40];
+    int n = snprintf(notice, sizeof(notice), "%lu log lines dropped\n", dropped - droppedReported);
+    if (!push(notice, n)) {
+      dropped++;
+      return;
+    }
+    droppedReported = dropped;
+  }
+
+  if (!push(line, len)) {
+    dropped++;
+  }
+}
+
+// Needs to be called by the main program loop frequently.
+// Drains only what the sink can take right now, so it never blocks.
+void LogHelper::loop() {
+#if LOG_SINK == LOG_SINK_UDP
+  if (WiFi.status() != WL_CONNECTED) {
+    return;
+  }
+  for (int i = 0; i < LOG_UDP_LINES_PER_LOOP && used > 0; i++) {
+    udp.beginPacket(LOG_UDP_HOST, LOG_UDP_PORT);
+    while (used > 0) {
+      char c = buffer[tail];
+      udp.write(c);
+      consume(1);
+      if (c == '\n') {
+        break;
+      }
+    }
+    udp.endPacket();
+  }
+#else
+  size_t room = Serial.availableForWrite();
+  while (used > 0 && room > 0) {
+    size_t n = min(min(room, used), LOG_BUFFER_SIZE - tail); // Up to the end of the buffer, at most
+    Serial.write((const uint8_t*)buffer + tail, n);
+    consume(n);
+    room -= n;
+  }
+#endif
+}
+
+// Drains everything, waiting as long as it takes.  For just before a restart or deep sleep.
+void LogHelper::flush() {
+  while (used > 0) {
+#if LOG_SINK == LOG_SINK_UDP
+    if (WiFi.status() != WL_CONNECTED) {
+      return;
+    }
+#endif
+    loop();
+    yield();
+  }
+#if LOG_SINK == LOG_SINK_SERIAL
+  Serial.flush();
+#endif
+}
+
+// Total lines thrown away because the buffer was full
+unsigned long LogHelper::getDropped() {
+  return dropped;
+}
+
+// Copies data in at the head, wrapping around the end of the buffer.  All or nothing.
+bool LogHelper::push(const char* data, size_t len) {
+  if (len > LOG_BUFFER_SIZE - used) {
+    return false;
+  }
+  size_t first = min(len, LOG_BUFFER_SIZE - head);
+  memcpy(buffer + head, data, first);
+  memcpy(buffer, data + first, len - first);
+  head = (head + len) % LOG_BUFFER_SIZE;
+  used += len;
+  return true;
+}
+
+// Frees len bytes from the tail, once they have been drained
+void LogHelper::consume(size_t len) {
+  tail = (tail + len) % LOG_BUFFER_SIZE;
+  used -= len;
+}
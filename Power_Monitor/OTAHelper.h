@@ -0,0 +1,55 @@
+//----------------------------------------------------------------------------------------------------------------
+// OTAHelper.h
+//
+// Pulls firmware updates over HTTP, as either a gzip-compressed image or a delta against the running firmware.
+// Interrupted downloads resume where they left off, and every image is MD5 checked before it is booted.
+// For ease, we define a global object that can be used for all update-related functions
+//
+// Author - Joshua Villwock
+// Created - 2026-10-19
+// License - Mozilla Public License 2.0 (Do what you want, credit the author, must release under same license)
+//----------------------------------------------------------------------------------------------------------------
+
+#ifndef __OTAHelper_H__
+#define __OTAHelper_H__
+
+#include <ESP8266WiFi.h>
+#include <ESP8266HTTPClient.h>
+#include <Updater.h>
+
+class OTAHelper
+{
+  const char* updateName;
+  unsigned long lastUpdateCheck;
+
+  // The download in progress.  Kept, with the updater left open, until it finishes or the manifest moves on.
+  String   partialURL;           // empty when there is nothing to resume
+  int      total;
+  uint32_t received;
+
+  // Delta decoder state.  Kept between reconnects and checks so a transfer can resume mid-patch.
+  bool     delta;
+  String   targetMD5;
+  byte     state;
+  byte     op;
+  uint8_t  args[48];
+  size_t   argsHave;
+  size_t   argsNeed;
+  uint32_t literalLeft;
+
+  bool readManifest(String& target, String& full);
+  byte fetch(const String& url, bool isDelta, const String& md5);
+  bool feed(uint8_t* data, size_t len);
+  bool handleArgs();
+  bool copyFromBase(uint32_t offset, uint32_t len);
+
+public:
+  void setup(const char* name);
+  void checkForUpdate();
+  bool update();
+  void cancel();
+};
+
+extern OTAHelper OTA_Helper;
+
+#endif //__OTAHelper_H__
@@ -13,6 +13,8 @@
 #include <EmonLib.h>
 #include <DHT.h>
 #include "MQTTHelper.h"
+#include "OTAHelper.h"
+#include "LogHelper.h"
 #include <ESP8266WiFi.h>
 #include <ArduinoOTA.h>
 extern "C" {
@@ -26,6 +28,8 @@ extern "C" {
 #define PASS ""        // your network password            //
 //---------------------------------------------------------//
 
+#define UPDATE_NAME "Power_Monitor" // where this node finds its firmware on the update server
+
 #define DHTTYPE DHT22     // I use DHT 22  (AM2302), AM2320, AM2321
 const int DHTPin = 4;     // pin the DHT is connected to
 bool fahrenheit = true;   // use fahrenheit?  Future versions will allow changing via MQTT
@@ -52,6 +56,7 @@ void setup() {
   MQTT_Helper.setup();
   otaInit();
   ArduinoOTA.setPassword((const char *)"123");
+  OTA_Helper.setup(UPDATE_NAME);
 }
 
 // Main program loop
@@ -62,6 +67,8 @@ void loop() {
   checkTempHumid();
   delay(100); //saves considerable power
   ArduinoOTA.handle();
+  OTA_Helper.checkForUpdate();
+  Log_Helper.loop();
 }
 
 // Initial connection to WiFi
@@ -122,21 +129,24 @@ float getHumidity() {
 
 void otaInit() {
   ArduinoOTA.onStart([]() {
-  Serial.println("Starting OTA");
+  LOG_INFO("OTA", "Starting OTA");
   });
   ArduinoOTA.onEnd([]() {
-  Serial.println("\nEnd of OTA");
+  LOG_INFO("OTA", "End of OTA");
+  Log_Helper.flush();
   });
   ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
-  Serial.printf("Progress: %u%%\r", (progress / (total / 100)));
+  LOG_DEBUG("OTA", "Progress: %u%%", (progress / (total / 100)));
   });
   ArduinoOTA.onError([](ota_error_t error) {
-  Serial.printf("Error[%u]: ", error);
-  if (error == OTA_AUTH_ERROR) Serial.println("Auth Failed");
-  else if (error == OTA_BEGIN_ERROR) Serial.println("Begin Failed");
-  else if (error == OTA_CONNECT_ERROR) Serial.println("Connect Failed");
-  else if (error == OTA_RECEIVE_ERROR) Serial.println("Receive Failed");
-  else if (error == OTA_END_ERROR) Serial.println("End Failed");
+  if (error == OTA_AUTH_ERROR) LOG_ERROR("OTA", "Error[%u]: Auth Failed", (unsigned)error);
+  else if (error == OTA_BEGIN_ERROR) {
+    LOG_ERROR("OTA", "Error[%u]: Begin Failed", (unsigned)error);
+    OTA_Helper.cancel(); // Our own unfinished download holds the updater, so the next push can have it
+  }
+  else if (error == OTA_CONNECT_ERROR) LOG_ERROR("OTA", "Error[%u]: Connect Failed", (unsigned)error);
+  else if (error == OTA_RECEIVE_ERROR) LOG_ERROR("OTA", "Error[%u]: Receive Failed", (unsigned)error);
+  else if (error == OTA_END_ERROR) LOG_ERROR("OTA", "Error[%u]: End Failed", (unsigned)error);
   });
   ArduinoOTA.begin();
 }
@@ -5,6 +5,7 @@
 //
 // Handles reading temperature, humidity, rain & wind speed for a weather station.
 // Transmits back results via serial for a ESP-based device in the attic to process and send via MQTT.
+// Sleeps between reports, waking on the wind & rain interrupts or the watchdog timer.
 // 
 // Author - Joshua Villwock
 // Created - 2016-02-20
@@ -12,6 +13,9 @@
 //----------------------------------------------------------------------------------------------------------------
 
 #include <DHT.h>
+#include <avr/sleep.h>
+#include <avr/power.h>
+#include <avr/wdt.h>
 
 #define LED_PIN    13 // LED connected to digital pin 13
 #define WIND_PIN   2  // Anemometer connected to digital (interrupt) pin 2
@@ -21,22 +25,38 @@
 #define TEMP_PIN_1_TYPE DHT22 // Temp Sensor type
 #define TEMP_PIN_1_DELAY 30   // How often to update sensor
 #define BATTERY_DELAY 120     // How often to update voltage
+#define AWAKE_DELAY   3600    // How often to report time spent awake
 
 #define TEXT_RAIN_FLIP "RAIN FLIP " // serial text to print on rain flip
 #define TEXT_WIND_UPDATE "W:"       // serial text to print on wind update
 #define TEXT_OUTSIDE     "T:"       // serial text to print for temperature
 #define TEXT_HUMIDITY    "H:"       // serial text to print for humidity
 #define TEXT_BATTERY     "B:"       // serial text to print for voltage
+#define TEXT_AWAKE       "A:"       // serial text to print for awake time
 
 #define WIND_DEBOUNCE_TIME 200     // MICROseconds before accepting more wind
 #define RAIN_DEBOUNCE_TIME 2000    // MILLIseconds before accepting new rain
 
+#define SLEEP_TICK_MS   250        // How long the watchdog lets us sleep.  Must match SLEEP_TICK_BITS
+#define SLEEP_TICK_BITS _BV(WDP2)  // Watchdog prescaler for 250ms (see the ATmega328P datasheet)
+#define LED_HEARTBEAT   false      // Flash the led every second without wind?  Costs power.
+#define WAKE_PINS       (_BV(PCINT18) | _BV(PCINT19)) // WIND_PIN & RAIN_PIN (PD2 & PD3) as pin change interrupts
+
 volatile unsigned long windDebounce = 0; // last wind debounce
 volatile unsigned long rainDebounce = 0; // last rain debounce
 unsigned long lastmillis  = 0;           // last time main loop reported
 volatile byte half_revolutions = 0;      // number of wind (half) revolutions since reset
 int tempCounter    = 0;                  // counter for how many seconds since last temp reading
 int batteryCounter = 0;                  // counter for how many seconds since last battery reading
+int awakeCounter   = 0;                  // counter for how many seconds since last awake report
+bool windActive    = false;              // if the last wind report saw any revolutions
+volatile bool wdtFired = false;          // set by the watchdog, so we know how long we slept
+volatile unsigned long lastTickMillis = 0; // millis() when the watchdog last fired
+volatile byte wakePins = 0;              // PIND as last seen by the pin change wake-up
+unsigned long wakeMicros  = 0;           // when we last woke up
+unsigned long awakeMicros = 0;           // time spent awake since last awake report
+
+extern volatile unsigned long timer0_millis; // Arduino's millis() counter, which stops while powered down
 
 DHT dht(TEMP_PIN_1, TEMP_PIN_1_TYPE);    // Declare the DHT sensor
 
@@ -48,15 +68,24 @@ void setup() {
 
   Serial.begin(9600);             // Start serial
   dht.begin();                    // Initialize the DHT sensor
-  
+
+  ADCSRA &= ~_BV(ADEN);           // ADC is only needed by readVcc()
+  power_adc_disable();
+  power_spi_disable();            // Nothing here uses SPI, I2C or the spare timers
+  power_twi_disable();
+  power_timer1_disable();
+  power_timer2_disable();
+  initWatchdog();                 // Wake us up periodically while asleep
+
   attachInterrupt(digitalPinToInterrupt(WIND_PIN), windInterrupt, FALLING); // attach interrupt handler
   attachInterrupt(digitalPinToInterrupt(RAIN_PIN), rainInterrupt, FALLING); // attach interrupt handler
+  PCMSK2 = WAKE_PINS;             // pin change wake-up for power down, only enabled while powered down
+  wakeMicros = micros();
 }
 
 // Main code, runs forever:
 void loop() {
   if (millis() - lastmillis >= 1000) {    // if it's been more than 1000ms:
-    noInterrupts();                         // disable interrupts when calculating
     Serial.print(TEXT_WIND_UPDATE);         // print header
     Serial.println(getWind(), DEC);         // print the rpm to serial
 
@@ -72,10 +101,92 @@ void loop() {
       batteryCounter++;                     // otherwise, increment loop count
     }
 
+    if (awakeCounter > AWAKE_DELAY) {     // if we've ran this loop 3600 times
+      updateAwake();                        // then report how long we were awake
+    } else {
+      awakeCounter++;                       // otherwise, increment loop count
+    }
+
     lastmillis = millis();                  // update lastmillis
-    interrupts();                           // re-enable interrupts
   }
-  delay(100); //saves considerable power & heat
+  goToSleep(); //saves considerable power & heat
+}
+
+// Sleeps until the next wind, rain or watchdog interrupt.
+// When calm we power down completely.  On the next watchdog tick we credit millis() with just the part of
+// that tick we slept through, since timer0 already counted the part we spent awake or idle.
+// While the wind is blowing we only idle, so the timers keep running and wind counts stay accurate.
+// The FALLING edge interrupts can't wake us from power down: the ATmega328P only wakes on INT0/INT1 for a LOW
+// level, as edge detection needs the I/O clock.  So power down wakes on a pin change instead, see PCINT2_vect.
+// millis() still drifts with the watchdog oscillator (around 10%) while powered down, and a power down
+// ended by wind or rain credits nothing, losing up to one tick.  Neither affects the awake time report.
+void goToSleep() {
+  Serial.flush();                 // let the UART finish, or power down cuts it off mid-byte
+  awakeMicros += micros() - wakeMicros;
+
+  byte mode = SLEEP_MODE_PWR_DOWN;
+  if (windActive || half_revolutions > 0) {
+    mode = SLEEP_MODE_IDLE;
+  }
+
+  set_sleep_mode(mode);
+  noInterrupts();
+  wdtFired = false;
+  unsigned long tickSpent = millis() - lastTickMillis; // part of this tick timer0 has already counted
+  sleep_enable();
+  if (mode == SLEEP_MODE_PWR_DOWN) {
+    wakePins = PIND;
+    PCIFR = _BV(PCIF2);           // forget changes from while we were awake
+    PCICR |= _BV(PCIE2);
+  }
+  #if defined(sleep_bod_disable)
+  if (mode == SLEEP_MODE_PWR_DOWN) {
+    sleep_bod_disable();          // brown-out detector off while asleep.  Must be right before sleep_cpu()
+  }
+  #endif
+  interrupts();                   // the next instruction always runs, so no interrupt can be missed
+  sleep_cpu();
+  sleep_disable();
+  PCICR &= ~_BV(PCIE2);           // awake or idle, the edge interrupts do the counting
+
+  if (mode == SLEEP_MODE_PWR_DOWN && wdtFired) {
+    noInterrupts();
+    if (tickSpent < SLEEP_TICK_MS) {
+      timer0_millis += SLEEP_TICK_MS - tickSpent;
+    }
+    lastTickMillis = timer0_millis;
+    interrupts();
+  }
+  wakeMicros = micros();
+}
+
+// Sets the watchdog to interrupt (not reset) every SLEEP_TICK_MS
+void initWatchdog() {
+  noInterrupts();
+  MCUSR &= ~_BV(WDRF);                 // clear any previous watchdog reset
+  WDTCSR = _BV(WDCE) | _BV(WDE);       // allow changes
+  WDTCSR = _BV(WDIE) | SLEEP_TICK_BITS; // interrupt mode only
+  interrupts();
+}
+
+// When the watchdog wakes us up
+ISR(WDT_vect) {
+  wdtFired = true;
+  lastTickMillis = millis();
+}
+
+// When a wind or rain pin changes while powered down.  The edge interrupt that should have counted a falling
+// edge didn't see it, so we pass it on here.  If it did see it after all, the debounce drops the second count.
+ISR(PCINT2_vect) {
+  byte pins = PIND;
+  byte fell = wakePins & ~pins;
+  wakePins = pins;
+  if (fell & _BV(PD2)) {
+    windInterrupt();
+  }
+  if (fell & _BV(PD3)) {
+    rainInterrupt();
+  }
 }
 
 // When wind gauge is triggered
@@ -126,14 +237,26 @@ void updateVoltage() {
   batteryCounter = 1;
 }
 
+//Called to send how many ms we spent awake since the last report
+void updateAwake() {
+  Serial.print(TEXT_AWAKE);
+  Serial.println(awakeMicros / 1000, DEC);
+  awakeMicros = 0;
+  awakeCounter = 1;
+}
+
 // gets the number of windTurns
 // also resets it and handles led blinking
 int getWind() {
-  if (half_revolutions == 0) { // if no revolutions,
-    ledOnFor(5);                 // then flash the led
-  }
+  noInterrupts();                // disable interrupts when calculating
   int rpm = half_revolutions;
   half_revolutions = 0;          // reset revolutions
+  interrupts();                  // re-enable interrupts
+
+  windActive = (rpm > 0);
+  if (!windActive && LED_HEARTBEAT) { // if no revolutions,
+    ledOnFor(5);                 // then flash the led
+  }
   return rpm;                    // return result
 }
 
@@ -147,6 +270,9 @@ void ledOnFor(int time) {
 // Measures the 5v power rail using the internal 1.1v vref backwards.
 // http://provideyourown.com/2012/secret-arduino-voltmeter-measure-battery-voltage/
 long readVcc() {
+  power_adc_enable();              // ADC is kept off between readings
+  ADCSRA |= _BV(ADEN);
+
   // Read 1.1V reference against AVcc
   // set the reference to Vcc and the measurement to the internal 1.1V reference
   #if defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
@@ -168,6 +294,9 @@ long readVcc() {
 
   long result = (high<<8) | low;   // combine result
 
+  ADCSRA &= ~_BV(ADEN);            // and back off again
+  power_adc_disable();
+
   result = 1125300L / result;      // Calculate Vcc (in mV); 1125300 = 1.1*1023*1000
   return result;                   // Vcc in millivolts
 }
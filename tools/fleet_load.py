@@ -0,0 +1,855 @@
+#!/usr/bin/env python3
+#----------------------------------------------------------------------------------------------------------------
+# fleet_load.py
+#
+# Load tests the MQTT broker and InfluxDB with a simulated fleet of our nodes, for capacity planning.
+# Each simulated node replays what its sketch actually sends: the same topics, payload formatting, intervals,
+# reconnect timers and one-connection-per-POST InfluxDB writes.  Time can be sped up, so an hour of fleet
+# traffic takes a minute.
+#
+#   fleet_load.py run   [--clock N] [--power N] [--micro N] [--attic N] [--switch N] [options]
+#   fleet_load.py serve [--mqtt-port 1883] [--influx-port 8086] [--influx-delay MS]
+#
+# run starts its own stand-in broker & InfluxDB unless --broker / --influx point it elsewhere.
+# serve runs just the stand-ins, so the load can come from another machine.
+# Run with -h for all the options (reconnect storms, deep sleep wake bursts, batched uplink, ...)
+#
+# Author - Joshua Villwock
+# Created - 2026-10-19
+# License - Mozilla Public License 2.0 (Do what you want, credit the author, must release under same license)
+#----------------------------------------------------------------------------------------------------------------
+
+import argparse
+import asyncio
+import collections
+import json
+import random
+import re
+import struct
+import sys
+import time
+
+#---------------------------------------------------------#
+#  Traffic patterns, as configured in each sketch         #
+#---------------------------------------------------------#
+CLOCK_TEMP_FREQUENCY   = 60    # NTPclock TEMPERATURE_UPDATE_FREQUENCY
+CLOCK_RECONNECT_TIME   = 10    # NTPclock MQTT_RECONNECT_TIME
+CLOCK_LOOP_DELAY       = 0.05  # NTPclock loop() delay
+POWER_TEMP_FREQUENCY   = 60    # Power_Monitor TEMP_HUMID_UPDATE_FREQUENCY
+POWER_RECONNECT_TIME   = 15    # Power_Monitor MQTT_RECONNECT_TIME
+POWER_LOOP_DELAY       = 0.1   # Power_Monitor loop() delay
+MICRO_UPDATE_FREQUENCY = 300   # Micro_Temp UPDATE_FREQUENCY (deep sleep time)
+MICRO_WIFI_TIME        = 2     # Micro_Temp time to associate after waking
+MICRO_AWAKE_TIME       = 1     # Micro_Temp loop() delay before going back to sleep
+ATTIC_TEMP_FREQUENCY   = 60    # Attic_Controller TEMP_HUMID_UPDATE_FREQUENCY
+ROOF_WIND_FREQUENCY    = 1     # roof_sensor_serial wind report
+ROOF_TEMP_FREQUENCY    = 31    # roof_sensor_serial counts past TEMP_PIN_1_DELAY (30) before reading
+ROOF_BATTERY_FREQUENCY = 121   # roof_sensor_serial counts past BATTERY_DELAY (120)
+ROOF_AWAKE_FREQUENCY   = 3601  # roof_sensor_serial counts past AWAKE_DELAY (3600)
+SWITCH_TEMP_FREQUENCY  = 60    # Computer_Switch TEMP_CHECK_FREQUENCY
+WIFI_CONNECT_DELAY     = 5     # connectWifi() waits this long before carrying on
+MQTT_KEEPALIVE         = 15    # PubSubClient MQTT_KEEPALIVE
+MQTT_SOCKET_TIMEOUT    = 15    # PubSubClient MQTT_SOCKET_TIMEOUT
+HTTP_TIMEOUT           = 5     # ESP8266HTTPClient default timeout
+SERIAL_BACKLOG         = 40    # Roof lines the attic can fall behind by before its 256 byte serial buffer overflows
+#---------------------------------------------------------#
+
+# MQTT packet types
+CONNECT, CONNACK, PUBLISH, PUBACK, SUBSCRIBE, SUBACK, PINGREQ, PINGRESP, DISCONNECT = 1, 2, 3, 4, 8, 9, 12, 13, 14
+
+NETWORK_ERRORS = (OSError, asyncio.TimeoutError, asyncio.IncompleteReadError, ConnectionError, ValueError)
+
+
+#----------------------------------------------------------------------------------------------------------------
+# Minimal MQTT 3.1.1 encoding, just what PubSubClient uses
+#----------------------------------------------------------------------------------------------------------------
+
+def mqtt_packet(ptype, flags, body):
+  header = bytearray([(ptype << 4) | flags])
+  length = len(body)
+  while True:
+    byte = length % 128
+    length //= 128
+    header.append(byte | 0x80 if length else byte)
+    if not length:
+      return bytes(header) + body
+
+
+def mqtt_string(s):
+  data = s.encode()
+  return struct.pack("!H", len(data)) + data
+
+
+def read_mqtt_string(body, pos):
+  (length,) = struct.unpack_from("!H", body, pos)
+  return body[pos + 2:pos + 2 + length].decode(errors="replace"), pos + 2 + length
+
+
+async def read_mqtt_packet(reader):
+  first = (await reader.readexactly(1))[0]
+  length, shift = 0, 0
+  while True:
+    byte = (await reader.readexactly(1))[0]
+    length |= (byte & 0x7f) << shift
+    shift += 7
+    if not byte & 0x80:
+      break
+    if shift > 21:
+      raise ValueError("bad remaining length")
+  return first >> 4, first & 0x0f, await reader.readexactly(length)
+
+
+def connect_packet(client_id, keepalive):
+  return mqtt_packet(CONNECT, 0, mqtt_string("MQTT") + bytes([4, 0x02]) + struct.pack("!H", keepalive) +
+                     mqtt_string(client_id))
+
+
+def publish_packet(topic, payload):
+  return mqtt_packet(PUBLISH, 0, mqtt_string(topic) + payload)
+
+
+def subscribe_packet(packet_id, topic, qos):
+  return mqtt_packet(SUBSCRIBE, 2, struct.pack("!H", packet_id) + mqtt_string(topic) + bytes([qos]))
+
+
+def parse_publish(flags, body):
+  topic, pos = read_mqtt_string(body, 0)
+  qos = (flags >> 1) & 3
+  packet_id = None
+  if qos:
+    (packet_id,) = struct.unpack_from("!H", body, pos)
+    pos += 2
+  return topic, qos, packet_id, body[pos:]
+
+
+def topic_matches(pattern, topic):
+  pattern_parts, topic_parts = pattern.split("/"), topic.split("/")
+  for i, part in enumerate(pattern_parts):
+    if part == "#":
+      return True
+    if i >= len(topic_parts) or (part != "+" and part != topic_parts[i]):
+      return False
+  return len(pattern_parts) == len(topic_parts)
+
+
+#----------------------------------------------------------------------------------------------------------------
+# Stand-in servers
+#----------------------------------------------------------------------------------------------------------------
+
+# Just enough of an MQTT broker: QoS 0/1 publish, subscribe, keepalive & client ID takeover
+class BrokerStandIn:
+  def __init__(self):
+    self.sessions      = {} # client id -> writer
+    self.subscriptions = {} # writer -> [topic filters]
+    self.connections   = 0
+    self.peak          = 0
+    self.publishes     = 0
+    self.takeovers     = 0
+    self.on_publish    = None # called with the sender's address for every publish received
+
+  async def start(self, host, port):
+    self.server = await asyncio.start_server(self.handle, host, port, backlog=1024)
+    return self.server.sockets[0].getsockname()[1]
+
+  async def handle(self, reader, writer):
+    peer = writer.get_extra_info("peername")
+    self.connections += 1
+    self.peak = max(self.peak, self.connections)
+    client_id, keepalive = None, 0
+    try:
+      while True:
+        timeout = keepalive * 1.5 if keepalive else None
+        ptype, flags, body = await asyncio.wait_for(read_mqtt_packet(reader), timeout)
+        if ptype == CONNECT:
+          _, pos = read_mqtt_string(body, 0)
+          (keepalive,) = struct.unpack_from("!H", body, pos + 2)
+          client_id, _ = read_mqtt_string(body, pos + 4)
+          old = self.sessions.get(client_id)
+          if old is not None:
+            self.takeovers += 1 # Same random ID as a connected node, which gets kicked off
+            old.transport.abort()
+          self.sessions[client_id] = writer
+          writer.write(mqtt_packet(CONNACK, 0, b"\x00\x00"))
+        elif ptype == PUBLISH:
+          topic, qos, packet_id, payload = parse_publish(flags, body)
+          self.publishes += 1
+          if self.on_publish is not None:
+            self.on_publish(peer)
+          if qos:
+            writer.write(mqtt_packet(PUBACK, 0, struct.pack("!H", packet_id)))
+          for subscriber, filters in self.subscriptions.items():
+            if any(topic_matches(f, topic) for f in filters):
+              subscriber.write(publish_packet(topic, payload))
+        elif ptype == SUBSCRIBE:
+          (packet_id,) = struct.unpack_from("!H", body, 0)
+          pos, granted = 2, bytearray()
+          while pos < len(body):
+            topic, pos = read_mqtt_string(body, pos)
+            pos += 1
+            self.subscriptions.setdefault(writer, []).append(topic)
+            granted.append(0)
+          writer.write(mqtt_packet(SUBACK, 0, struct.pack("!H", packet_id) + granted))
+        elif ptype == PINGREQ:
+          writer.write(mqtt_packet(PINGRESP, 0, b""))
+        elif ptype == DISCONNECT:
+          break
+    except NETWORK_ERRORS:
+      pass
+    finally:
+      self.connections -= 1
+      self.subscriptions.pop(writer, None)
+      if self.sessions.get(client_id) is writer:
+        del self.sessions[client_id]
+      writer.close()
+
+
+# Just enough of InfluxDB's /write: checks each line protocol line, answers 204 or 400 like the real thing
+class InfluxStandIn:
+  def __init__(self, delay):
+    self.delay    = delay
+    self.active   = 0
+    self.peak     = 0
+    self.requests = 0
+    self.accepted = 0
+    self.rejected = 0
+
+  async def start(self, host, port):
+    self.server = await asyncio.start_server(self.handle, host, port, backlog=1024)
+    return self.server.sockets[0].getsockname()[1]
+
+  # Why InfluxDB would refuse a line, or None if it parses
+  @staticmethod
+  def line_error(line):
+    parts = re.split(r"(?<!\\) ", line.rstrip())
+    if len(parts) < 2 or not parts[0]:
+      return "missing fields"
+    if any(not key or not value for key, _, value in (f.partition("=") for f in parts[1].split(","))):
+      return "invalid field format"
+    if len(parts) > 3 or (len(parts) == 3 and not parts[2].lstrip("-").isdigit()):
+      return "bad timestamp"
+    return None
+
+  async def handle(self, reader, writer):
+    self.active += 1
+    self.peak = max(self.peak, self.active)
+    try:
+      await reader.readline()
+      length = 0
+      while True:
+        header = await reader.readline()
+        if header in (b"\r\n", b"\n", b""):
+          break
+        name, _, value = header.decode("latin-1").partition(":")
+        if name.strip().lower() == "content-length":
+          length = int(value)
+      body = await reader.readexactly(length)
+      if self.delay:
+        await asyncio.sleep(self.delay)
+
+      lines = [l for l in body.decode(errors="replace").split("\n") if l.strip()]
+      errors = ["unable to parse '%s': %s" % (l, self.line_error(l)) for l in lines if self.line_error(l)]
+      self.requests += 1
+      self.accepted += len(lines) - len(errors)
+      self.rejected += len(errors)
+      if not errors:
+        writer.write(b"HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n")
+      else:
+        # The good lines are still written.  The error names each bad one, as InfluxDB 1.x does.
+        error = json.dumps({"error": "partial write: " + "\n".join(errors)}).encode()
+        writer.write(b"HTTP/1.1 400 Bad Request\r\nContent-Type: application/json\r\nConnection: close\r\n"
+                     b"Content-Length: %d\r\n\r\n%s" % (len(error), error))
+      await writer.drain()
+    except NETWORK_ERRORS:
+      pass
+    finally:
+      self.active -= 1
+      writer.close()
+
+
+#----------------------------------------------------------------------------------------------------------------
+# The simulated fleet
+#----------------------------------------------------------------------------------------------------------------
+
+class Stats:
+  def __init__(self):
+    self.publish_sent      = 0
+    self.publish_offline   = 0 # published while disconnected, which PubSubClient silently drops
+    self.publish_delivered = 0
+    self.publish_latency   = []
+    self.publish_topics    = set()
+    self.exact_latency     = False # True when the stand-in broker tells us which connection each publish came in on
+    self.sent_times        = collections.defaultdict(collections.deque) # send times not yet matched, see publish()
+    self.connect_attempts  = 0
+    self.connect_failed    = 0
+    self.connect_latency   = []
+    self.http_requests     = 0
+    self.http_lines        = 0
+    self.http_failed_lines = 0 # lines in posts that got no usable answer
+    self.http_partial      = 0 # posts answered with a partial write
+    self.http_parse_errors = 0 # lines those partial writes refused
+    self.http_backlog      = 0 # lines lost because the node fell too far behind
+    self.http_latency      = []
+    self.http_status       = collections.Counter()
+
+
+class Fleet:
+  def __init__(self, args, batch_lines, broker, influx):
+    self.args        = args
+    self.speed       = args.speed
+    self.batch_lines = batch_lines
+    self.batch_age   = args.batch_age
+    self.broker      = broker
+    self.influx      = influx
+    self.rng         = random.Random(args.seed)
+    self.stats       = Stats()
+    self.clients     = set()
+    self.uplinks     = []
+    self.running     = True
+    self.start       = time.monotonic()
+
+  # Simulated seconds since the run started
+  def now(self):
+    return (time.monotonic() - self.start) * self.speed
+
+  async def sleep(self, seconds):
+    await asyncio.sleep(max(0, seconds) / self.speed)
+
+  # Sleeps until simulated time t, or until event is set
+  async def sleep_until(self, t, event=None):
+    delay = max(0, t - self.now()) / self.speed
+    if event is None:
+      await asyncio.sleep(delay)
+      return
+    try:
+      await asyncio.wait_for(event.wait(), delay)
+    except asyncio.TimeoutError:
+      pass
+
+  def client_id(self):
+    return "ESP8266Client-%x" % self.rng.randrange(0xffff) # Same as MQTTHelper, collisions and all
+
+  # The stand-in broker got a publish from this address.  TCP keeps each connection in order, so it's the oldest one
+  # that node sent.
+  def publish_arrived(self, address):
+    sent = self.stats.sent_times.get(address)
+    if sent:
+      self.stats.publish_latency.append((time.monotonic() - sent.popleft()) * 1000)
+
+  def temperature(self):
+    return self.rng.gauss(70, 8)
+
+  def humidity(self):
+    return self.rng.uniform(25, 70)
+
+
+# A node's MQTT connection, as PubSubClient would make it
+class MQTTClient:
+  def __init__(self, fleet):
+    self.fleet  = fleet
+    self.writer = None
+    self.local  = None # our end of the connection, which is how the stand-in broker knows us
+    self.tasks  = []
+    self.closed = asyncio.Event()
+    self.closed.set()
+
+  @property
+  def connected(self):
+    return not self.closed.is_set()
+
+  async def connect(self, subscribe=None):
+    stats = self.fleet.stats
+    stats.connect_attempts += 1
+    started = time.monotonic()
+    writer = None
+    try:
+      reader, writer = await asyncio.wait_for(asyncio.open_connection(*self.fleet.broker), MQTT_SOCKET_TIMEOUT)
+      writer.write(connect_packet(self.fleet.client_id(), MQTT_KEEPALIVE))
+      ptype, _, body = await asyncio.wait_for(read_mqtt_packet(reader), MQTT_SOCKET_TIMEOUT)
+      if ptype != CONNACK or body[1] != 0:
+        raise ConnectionError("refused")
+    except NETWORK_ERRORS:
+      stats.connect_failed += 1
+      if writer is not None:
+        writer.transport.abort()
+      return False
+
+    stats.connect_latency.append((time.monotonic() - started) * 1000)
+    self.writer = writer
+    self.local  = writer.get_extra_info("sockname")
+    self.closed = asyncio.Event()
+    self.fleet.clients.add(self)
+    if subscribe:
+      writer.write(subscribe_packet(1, subscribe, 1))
+    self.tasks = [asyncio.ensure_future(self.read(reader)), asyncio.ensure_future(self.keepalive())]
+    return True
+
+  def publish(self, topic, payload):
+    stats = self.fleet.stats
+    if not self.connected or self.writer.is_closing():
+      stats.publish_offline += 1
+      return
+    self.writer.write(publish_packet(topic, payload.encode()))
+    stats.publish_sent += 1
+    stats.publish_topics.add(topic)
+    # Matched per connection by the stand-in broker, or else per topic, in send order, by the monitor
+    if stats.exact_latency:
+      stats.sent_times[self.local].append(time.monotonic())
+    else:
+      stats.sent_times[topic].append((time.monotonic(), self))
+
+  async def read(self, reader):
+    try:
+      while True:
+        await read_mqtt_packet(reader) # Brightness updates & ping replies, which we don't act on
+    except NETWORK_ERRORS:
+      pass
+    self.lost()
+
+  async def keepalive(self):
+    while self.connected:
+      await self.fleet.sleep(MQTT_KEEPALIVE)
+      if self.connected and not self.writer.is_closing():
+        self.writer.write(mqtt_packet(PINGREQ, 0, b""))
+
+  # Whatever we sent that hasn't been matched yet never will be, so it must not be matched to anyone else's sends
+  def forget_sent(self):
+    sent_times = self.fleet.stats.sent_times
+    if self.fleet.stats.exact_latency:
+      sent_times.pop(self.local, None)
+      return
+    for topic, sent in sent_times.items():
+      if any(client is self for _, client in sent):
+        sent_times[topic] = collections.deque(entry for entry in sent if entry[1] is not self)
+
+  def lost(self):
+    if self.connected:
+      self.closed.set()
+      self.fleet.clients.discard(self)
+      self.forget_sent()
+      for task in self.tasks:
+        if task is not asyncio.current_task():
+          task.cancel()
+
+  # Drops the connection on the spot, like a WiFi outage
+  def abort(self):
+    if self.writer is not None:
+      self.writer.transport.abort()
+    self.lost()
+
+  # Goes quiet without closing, like deep sleep.  The broker only notices once the keepalive runs out.
+  def abandon(self):
+    writer = self.writer
+    self.lost()
+    asyncio.get_event_loop().call_later(MQTT_KEEPALIVE * 1.5 / self.fleet.speed, writer.transport.abort)
+
+
+# A node's InfluxDB writes.  Each POST is its own connection, and the node waits on it, just like
+# HTTPClient in the sketches.  With batching, lines are held back and sent several to a POST.
+class InfluxUplink:
+  def __init__(self, fleet):
+    self.fleet = fleet
+    self.queue = collections.deque()
+    self.wake  = asyncio.Event()
+    self.limit = SERIAL_BACKLOG + fleet.batch_lines
+    self.task  = asyncio.ensure_future(self.worker())
+    fleet.uplinks.append(self)
+
+  def submit(self, line):
+    if len(self.queue) >= self.limit:
+      self.fleet.stats.http_backlog += 1
+      return
+    self.queue.append((line, self.fleet.now()))
+    self.wake.set()
+
+  async def worker(self):
+    fleet = self.fleet
+    while fleet.running or self.queue:
+      if not self.queue:
+        self.wake.clear()
+        await fleet.sleep_until(fleet.now() + 1, self.wake)
+        continue
+      if len(self.queue) < fleet.batch_lines and fleet.running:
+        oldest = self.queue[0][1]
+        if fleet.now() < oldest + fleet.batch_age:
+          self.wake.clear()
+          await fleet.sleep_until(oldest + fleet.batch_age, self.wake)
+          continue
+      lines = [self.queue.popleft()[0] for _ in range(min(fleet.batch_lines, len(self.queue)))]
+      await self.post(lines)
+
+  async def post(self, lines):
+    stats = self.fleet.stats
+    host, port = self.fleet.influx
+    body = "\n".join(lines).encode()
+    request = ("POST /write?db=sensors HTTP/1.1\r\nHost: %s:%d\r\nUser-Agent: ESP8266HTTPClient\r\n"
+               "Connection: close\r\nContent-Length: %d\r\n\r\n" % (host, port, len(body))).encode() + body
+    stats.http_requests += 1
+    stats.http_lines += len(lines)
+    started = time.monotonic()
+    writer, response = None, b""
+    try:
+      reader, writer = await asyncio.wait_for(asyncio.open_connection(host, port), HTTP_TIMEOUT)
+      writer.write(request)
+      status = await asyncio.wait_for(reader.readline(), HTTP_TIMEOUT)
+      code = int(status.split()[1])
+      response = await asyncio.wait_for(reader.read(), HTTP_TIMEOUT)
+    except (NETWORK_ERRORS + (IndexError,)) as e:
+      code = "timeout" if isinstance(e, asyncio.TimeoutError) else "error"
+    finally:
+      if writer is not None:
+        writer.close()
+    stats.http_status[code] += 1
+    refused = self.refused_lines(response) if code == 400 else 0
+    if code in (200, 204) or refused:
+      stats.http_latency.append((time.monotonic() - started) * 1000)
+    if refused:
+      stats.http_partial += 1
+      stats.http_parse_errors += min(refused, len(lines))
+    elif code not in (200, 204):
+      stats.http_failed_lines += len(lines)
+
+  # A 400 still writes every line it could parse, and names the ones it couldn't.  0 if this isn't that kind of 400.
+  @staticmethod
+  def refused_lines(response):
+    _, _, body = response.partition(b"\r\n\r\n")
+    try:
+      error = json.loads(body.decode(errors="replace"))["error"]
+    except (ValueError, KeyError, TypeError):
+      return 0
+    return error.count("unable to parse") if error.startswith("partial write") else 0
+
+
+# Runs callbacks on their own intervals.  Each entry is [next time, interval function, callback].
+async def run_schedule(fleet, schedule):
+  while True:
+    entry = min(schedule, key=lambda e: e[0])
+    await fleet.sleep_until(entry[0])
+    entry[0] += entry[1]()
+    entry[2]()
+
+
+# NTPclock & Power_Monitor: stay connected, reconnect on a timer, publish on a timer
+async def mqtt_node(fleet, reconnect_time, frequency, loop_delay, publish, subscribe=None):
+  await fleet.sleep(fleet.rng.uniform(0, frequency)) # Nodes were plugged in at different times
+  boot = fleet.now()
+  client = MQTTClient(fleet)
+  # Connect as soon as WiFi is up.  The sketches' lastMQTTReconnect starts at 0, so real nodes hold off until
+  # millis() passes one reconnect period, but connecting early is the harsher case for boot bursts.
+  last_attempt = boot - reconnect_time
+  next_publish = boot + frequency
+  await fleet.sleep(WIFI_CONNECT_DELAY)
+  try:
+    while True:
+      now = fleet.now()
+      if not client.connected and now > last_attempt + reconnect_time:
+        last_attempt = now
+        await client.connect(subscribe)
+      if now >= next_publish:
+        publish(client)
+        next_publish = fleet.now() + frequency
+      wake = next_publish
+      if not client.connected:
+        wake = min(wake, last_attempt + reconnect_time)
+      await fleet.sleep_until(wake + fleet.rng.uniform(0, loop_delay), client.closed if client.connected else None)
+  finally:
+    client.abort()
+
+
+def clock_node(fleet):
+  def publish(client):
+    client.publish("home/jroom/clock/temp", "%6.2f" % fleet.temperature())
+  return mqtt_node(fleet, CLOCK_RECONNECT_TIME, CLOCK_TEMP_FREQUENCY, CLOCK_LOOP_DELAY, publish,
+                   "home/jroom/clock/brightness")
+
+
+def power_node(fleet):
+  def publish(client):
+    client.publish("home/garage/power/temp",  "%6.2f" % fleet.temperature())
+    client.publish("home/garage/power/humid", "%6.2f" % fleet.humidity())
+  return mqtt_node(fleet, POWER_RECONNECT_TIME, POWER_TEMP_FREQUENCY, POWER_LOOP_DELAY, publish)
+
+
+# Micro_Temp: wake, connect, publish twice, then deep sleep without disconnecting
+async def micro_node(fleet):
+  if not fleet.args.wake_sync:
+    await fleet.sleep(fleet.rng.uniform(0, MICRO_UPDATE_FREQUENCY))
+  client = MQTTClient(fleet)
+  try:
+    while True:
+      await fleet.sleep(MICRO_WIFI_TIME)
+      await client.connect()
+      client.publish("home/living/micro/temp",  "%-6.2f" % fleet.temperature())
+      client.publish("home/living/micro/humid", "%-6.2f" % fleet.humidity())
+      await fleet.sleep(MICRO_AWAKE_TIME)
+      if client.connected:
+        client.abandon()
+      await fleet.sleep(MICRO_UPDATE_FREQUENCY)
+  finally:
+    client.abort()
+
+
+# Attic_Controller: its own temp / humidity, plus relaying everything the roof sensor sends
+async def attic_node(fleet):
+  uplink = InfluxUplink(fleet)
+  rng = fleet.rng
+
+  def attic():
+    temp, humid = "%-6.2f" % fleet.temperature(), "%-6.2f" % fleet.humidity()
+    uplink.submit("weather,location=ATTIC Temperature=" + temp + ",Humidity=" + humid)
+
+  def roof(field, value):
+    return lambda: uplink.submit("weather,location=ROOF %s=%s" % (field, value()))
+
+  def roof_temp():
+    uplink.submit("weather,location=ROOF Temperature=%.2f" % fleet.temperature())
+    uplink.submit("weather,location=ROOF Humidity=%.2f" % fleet.humidity())
+
+  now = fleet.now()
+  schedule = [
+    [now + rng.uniform(0, ATTIC_TEMP_FREQUENCY),   lambda: ATTIC_TEMP_FREQUENCY,   attic],
+    [now + rng.uniform(0, ROOF_WIND_FREQUENCY),    lambda: ROOF_WIND_FREQUENCY,    roof("WindSpeed", lambda: rng.randint(0, 20))],
+    [now + rng.uniform(0, ROOF_TEMP_FREQUENCY),    lambda: ROOF_TEMP_FREQUENCY,    roof_temp],
+    [now + rng.uniform(0, ROOF_BATTERY_FREQUENCY), lambda: ROOF_BATTERY_FREQUENCY, roof("Battery", lambda: rng.randint(4600, 5100))],
+    [now + rng.uniform(0, ROOF_AWAKE_FREQUENCY),   lambda: ROOF_AWAKE_FREQUENCY,   roof("AwakeTime", lambda: rng.randint(20000, 90000))],
+  ]
+  if fleet.args.rain_rate > 0:
+    rain_gap = lambda: rng.expovariate(fleet.args.rain_rate / 3600.0)
+    schedule.append([now + rain_gap(), rain_gap, roof("RainFlip", lambda: 1)])
+  await run_schedule(fleet, schedule)
+
+
+# Computer_Switch: one temperature write a minute
+async def switch_node(fleet):
+  uplink = InfluxUplink(fleet)
+
+  def temp():
+    uplink.submit("weather,location=PLAYHOUSE Temperature=" + "%-6.2f" % fleet.temperature())
+
+  await run_schedule(fleet, [[fleet.now() + fleet.rng.uniform(0, SWITCH_TEMP_FREQUENCY),
+                              lambda: SWITCH_TEMP_FREQUENCY, temp]])
+
+
+# Subscribes to everything the fleet publishes, to count what actually makes it through the broker
+async def monitor(fleet, ready):
+  stats = fleet.stats
+  reader, writer = await asyncio.open_connection(*fleet.broker)
+  writer.write(connect_packet("fleet_load-monitor", 0))
+  writer.write(subscribe_packet(1, "home/#", 0))
+  ready.set()
+  try:
+    while True:
+      ptype, flags, body = await read_mqtt_packet(reader)
+      if ptype != PUBLISH:
+        continue
+      topic, _, _, _ = parse_publish(flags, body)
+      if stats.exact_latency:
+        if topic in stats.publish_topics:
+          stats.publish_delivered += 1
+        continue
+      sent = stats.sent_times.get(topic)
+      if sent:
+        stats.publish_delivered += 1
+        stats.publish_latency.append((time.monotonic() - sent.popleft()[0]) * 1000)
+  finally:
+    writer.close()
+
+
+# Drops every node's MQTT connection at once, at each of the given simulated times
+async def storms(fleet, times):
+  for t in sorted(times):
+    await fleet.sleep_until(t)
+    for client in list(fleet.clients):
+      client.abort()
+
+
+#----------------------------------------------------------------------------------------------------------------
+# Running & reporting
+#----------------------------------------------------------------------------------------------------------------
+
+def percentile(values, q):
+  if not values:
+    return float("nan")
+  values = sorted(values)
+  return values[min(len(values) - 1, int(q * len(values)))]
+
+
+def latency_columns(values):
+  return "".join("%9.1f" % percentile(values, q) for q in (0.5, 0.9, 0.99, 1.0))
+
+
+def report(label, fleet, elapsed, broker, influx):
+  s, a = fleet.stats, fleet.args
+  print("== %s: clock %d, power %d, micro %d, attic %d, switch %d for %.0fs at %gx (%.1f simulated minutes)" %
+        (label, a.clock, a.power, a.micro, a.attic, a.switch, elapsed, a.speed, elapsed * a.speed / 60))
+  print("%-16s %9s %9s %9s %9s %9s %9s %9s %9s" % ("", "sent", "ok", "lost", "per sec", "p50 ms", "p90 ms",
+                                                 "p99 ms", "max ms"))
+  if s.publish_sent or s.publish_offline:
+    lost = s.publish_sent - s.publish_delivered + s.publish_offline
+    print("%-16s %9d %9d %9d %9.1f%s" % ("mqtt publish", s.publish_sent + s.publish_offline, s.publish_delivered,
+                                         lost, s.publish_delivered / elapsed, latency_columns(s.publish_latency)))
+    print("  mqtt publish latency: %s" % ("node to stand-in broker, matched per connection" if s.exact_latency else
+                                          "node to subscriber, matched per topic in send order"))
+  if s.connect_attempts:
+    print("%-16s %9d %9d %9d %9.1f%s" % ("mqtt connect", s.connect_attempts, s.connect_attempts - s.connect_failed,
+                                         s.connect_failed, s.connect_attempts / elapsed,
+                                         latency_columns(s.connect_latency)))
+  if s.http_lines or s.http_backlog:
+    ok = s.http_lines - s.http_failed_lines - s.http_parse_errors
+    print("%-16s %9d %9d %9d %9.1f%s" % ("influx lines", s.http_lines + s.http_backlog, ok,
+                                         s.http_failed_lines + s.http_parse_errors + s.http_backlog, ok / elapsed, ""))
+    print("%-16s %9d %9d %9d %9.1f%s" % ("influx posts", s.http_requests, len(s.http_latency),
+                                         s.http_requests - len(s.http_latency), s.http_requests / elapsed,
+                                         latency_columns(s.http_latency)))
+    print("  influx status: %s" % ", ".join("%s x%d" % (k, v) for k, v in sorted(s.http_status.items(), key=str)))
+    if s.http_partial:
+      print("  influx partial writes: %d posts had lines refused, %d lines refused in all" %
+            (s.http_partial, s.http_parse_errors))
+  if s.publish_offline or s.http_backlog:
+    print("  lost before sending: %d publishes while disconnected, %d lines over the node backlog" %
+          (s.publish_offline, s.http_backlog))
+  if broker is not None:
+    print("  stand-in broker: %d publishes, peak %d connections, %d client ID takeovers" %
+          (broker.publishes, broker.peak, broker.takeovers))
+  if influx is not None:
+    print("  stand-in influx: %d requests, %d lines accepted, %d rejected, peak %d concurrent" %
+          (influx.requests, influx.accepted, influx.rejected, influx.peak))
+  print()
+
+
+def parse_address(text, default_port):
+  host, _, port = text.rpartition(":")
+  return (host, int(port)) if host else (text, default_port)
+
+
+async def run_once(args, label, batch_lines):
+  broker = influx = None
+  if args.broker:
+    broker_address = parse_address(args.broker, 1883)
+  else:
+    broker = BrokerStandIn()
+    broker_address = ("127.0.0.1", await broker.start("127.0.0.1", 0))
+  if args.influx:
+    influx_address = parse_address(args.influx, 8086)
+  else:
+    influx = InfluxStandIn(args.influx_delay / 1000.0)
+    influx_address = ("127.0.0.1", await influx.start("127.0.0.1", 0))
+
+  fleet = Fleet(args, batch_lines, broker_address, influx_address)
+  if broker is not None:
+    broker.on_publish = fleet.publish_arrived
+    fleet.stats.exact_latency = True
+  ready = asyncio.Event()
+  monitor_task = asyncio.ensure_future(monitor(fleet, ready))
+  await ready.wait()
+
+  nodes = ([clock_node(fleet) for _ in range(args.clock)] + [power_node(fleet) for _ in range(args.power)] +
+           [micro_node(fleet) for _ in range(args.micro)] + [attic_node(fleet) for _ in range(args.attic)] +
+           [switch_node(fleet) for _ in range(args.switch)] + [storms(fleet, args.storm_at)])
+  tasks = [asyncio.ensure_future(n) for n in nodes]
+  fleet.start = time.monotonic()
+  await asyncio.sleep(args.duration)
+  elapsed = time.monotonic() - fleet.start
+
+  # Stop making traffic, then give what's in flight a moment to land before counting
+  fleet.running = False
+  for task in tasks:
+    task.cancel()
+  await asyncio.gather(*tasks, return_exceptions=True)
+  stopped = time.monotonic()
+  for uplink in fleet.uplinks:
+    uplink.wake.set()
+  if fleet.uplinks:
+    await asyncio.wait([u.task for u in fleet.uplinks], timeout=args.grace)
+  await asyncio.sleep(max(0, stopped + args.grace - time.monotonic()))
+  for uplink in fleet.uplinks:
+    uplink.task.cancel()
+  monitor_task.cancel()
+  await asyncio.gather(monitor_task, *[u.task for u in fleet.uplinks], return_exceptions=True)
+
+  report(label, fleet, elapsed, broker, influx)
+  for server in (broker, influx):
+    if server is not None:
+      server.server.close()
+
+
+async def run(args):
+  if args.compare:
+    await run_once(args, "unbatched", 1)
+    await run_once(args, "batched x%d" % args.batch_lines, args.batch_lines)
+  else:
+    await run_once(args, "batched x%d" % args.batch_lines if args.batch_lines > 1 else "unbatched", args.batch_lines)
+
+
+async def serve(args):
+  broker, influx = BrokerStandIn(), InfluxStandIn(args.influx_delay / 1000.0)
+  await broker.start(args.host, args.mqtt_port)
+  await influx.start(args.host, args.influx_port)
+  print("broker on %s:%d, influx on %s:%d" % (args.host, args.mqtt_port, args.host, args.influx_port))
+  last_publishes = last_lines = 0
+  while True:
+    await asyncio.sleep(10)
+    lines = influx.accepted + influx.rejected
+    print("%d connections (peak %d), %.1f publishes/s, %.1f influx lines/s, %d rejected, %d takeovers" %
+          (broker.connections, broker.peak, (broker.publishes - last_publishes) / 10.0,
+           (lines - last_lines) / 10.0, influx.rejected, broker.takeovers))
+    last_publishes, last_lines = broker.publishes, lines
+
+
+# Hundreds of nodes, each with a socket or two on both ends, runs past the usual 1024 file limit
+def raise_file_limit():
+  try:
+    import resource
+    soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+    resource.setrlimit(resource.RLIMIT_NOFILE, (hard, hard))
+  except (ImportError, ValueError, OSError):
+    pass
+
+
+def main(argv):
+  parser = argparse.ArgumentParser(description="Load test the broker & InfluxDB with a simulated fleet of nodes.")
+  commands = parser.add_subparsers(dest="command")
+
+  r = commands.add_parser("run", help="simulate a fleet")
+  r.add_argument("--clock",  type=int, default=0, help="NTPclock nodes (MQTT)")
+  r.add_argument("--power",  type=int, default=0, help="Power_Monitor nodes (MQTT)")
+  r.add_argument("--micro",  type=int, default=0, help="Micro_Temp nodes (MQTT, deep sleep)")
+  r.add_argument("--attic",  type=int, default=0, help="Attic_Controller + roof sensor pairs (InfluxDB)")
+  r.add_argument("--switch", type=int, default=0, help="Computer_Switch nodes (InfluxDB)")
+  r.add_argument("--duration", type=float, default=60, help="seconds to run for (default 60)")
+  r.add_argument("--speed", type=float, default=1, help="simulated seconds per real second (default 1)")
+  r.add_argument("--broker", help="host[:port] of a real broker, instead of the stand-in")
+  r.add_argument("--influx", help="host[:port] of a real InfluxDB, instead of the stand-in")
+  r.add_argument("--influx-delay", type=float, default=0, help="ms the stand-in InfluxDB takes per request")
+  r.add_argument("--storm-at", type=float, action="append", default=[], metavar="SECONDS",
+                 help="simulated time to drop every MQTT connection at once (repeatable)")
+  r.add_argument("--wake-sync", action="store_true", help="wake every Micro_Temp node at the same moment")
+  r.add_argument("--rain-rate", type=float, default=0, help="rain flips per hour per roof sensor")
+  r.add_argument("--batch-lines", type=int, default=1, help="InfluxDB lines per POST (1 = what the sketches do)")
+  r.add_argument("--batch-age", type=float, default=10, help="simulated seconds a line may wait for its batch")
+  r.add_argument("--compare", action="store_true", help="run unbatched, then batched, and report both")
+  r.add_argument("--grace", type=float, default=2, help="seconds to wait for in-flight traffic at the end")
+  r.add_argument("--seed", type=int, default=1)
+
+  s = commands.add_parser("serve", help="run just the stand-in broker & InfluxDB")
+  s.add_argument("--host", default="0.0.0.0")
+  s.add_argument("--mqtt-port", type=int, default=1883)
+  s.add_argument("--influx-port", type=int, default=8086)
+  s.add_argument("--influx-delay", type=float, default=0, help="ms taken per request")
+
+  args = parser.parse_args(argv[1:])
+  if args.command is None:
+    parser.print_help()
+    return 2
+  if args.command == "run" and args.compare and args.batch_lines < 2:
+    args.batch_lines = 10
+
+  raise_file_limit()
+  try:
+    asyncio.run(run(args) if args.command == "run" else serve(args))
+  except KeyboardInterrupt:
+    pass
+  return 0
+
+
+if __name__ == "__main__":
+  sys.exit(main(sys.argv))
@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+#----------------------------------------------------------------------------------------------------------------
+# ota_delta.py
+#
+# Builds the files OTAHelper pulls updates from: compressed full images and deltas against older firmware.
+# Every delta is applied back onto its base before it is written, and must rebuild the new image exactly.
+#
+#   ota_delta.py make    <old.bin> <new.bin> <out.hdlt>          write one delta
+#   ota_delta.py apply   <old.bin> <in.hdlt> <out.bin>           rebuild an image from a delta
+#   ota_delta.py publish <name> <new.bin> <dir> [old.bin ...]    lay out <dir>/<name>/ for the update server
+#
+# <name> is the node's UPDATE_NAME, not its hostname, since several nodes may share a hostname.
+#
+# The .bin files are the ones the Arduino IDE exports (Sketch -> Export compiled Binary).
+# The .bin.gz written by publish can also be pushed through ArduinoOTA / espota.py as-is.
+#
+# Author - Joshua Villwock
+# Created - 2026-10-19
+# License - Mozilla Public License 2.0 (Do what you want, credit the author, must release under same license)
+#----------------------------------------------------------------------------------------------------------------
+
+import gzip
+import hashlib
+import os
+import struct
+import sys
+
+MAGIC   = b"HDLT"
+VERSION = 1
+HEADER  = struct.Struct("<4sB3xI16sI16s") # magic, version, base size, base md5, target size, target md5
+
+OP_END  = 0x00 # no arguments
+OP_COPY = 0x01 # u32 offset, u32 length: copy from the base image
+OP_DATA = 0x02 # u32 length, then that many literal bytes
+
+KEY_SIZE   = 8   # bytes hashed to find candidate matches
+MIN_COPY   = 16  # shorter matches cost more as a COPY than as literal data
+CANDIDATES = 8   # base positions remembered per key
+
+
+# Indexes every position in the base image by the KEY_SIZE bytes starting there
+def index_base(base):
+  index = {}
+  for pos in range(len(base) - KEY_SIZE + 1):
+    positions = index.setdefault(base[pos:pos + KEY_SIZE], [])
+    if len(positions) < CANDIDATES:
+      positions.append(pos)
+  return index
+
+
+# Length of the common run starting at base[b] and target[t]
+def match_length(base, b, target, t):
+  length = 0
+  limit = min(len(base) - b, len(target) - t)
+  while length < limit and base[b + length] == target[t + length]:
+    length += 1
+  return length
+
+
+# Greedy delta: at each target position, take the longest copy we can find in the base,
+# trying the spot right after the previous copy first, since code mostly moves in blocks.
+def make_delta(base, target):
+  index = index_base(base)
+  out = bytearray(HEADER.pack(MAGIC, VERSION, len(base), hashlib.md5(base).digest(),
+                              len(target), hashlib.md5(target).digest()))
+  literal = bytearray()
+  next_base = 0
+  t = 0
+
+  def flush_literal():
+    if literal:
+      out.extend(struct.pack("<BI", OP_DATA, len(literal)))
+      out.extend(literal)
+      literal.clear()
+
+  while t < len(target):
+    best_pos, best_len = 0, 0
+    candidates = index.get(bytes(target[t:t + KEY_SIZE]), [])
+    for pos in [next_base] + candidates:
+      length = match_length(base, pos, target, t) if pos < len(base) else 0
+      if length > best_len:
+        best_pos, best_len = pos, length
+
+    if best_len >= MIN_COPY:
+      flush_literal()
+      out.extend(struct.pack("<BII", OP_COPY, best_pos, best_len))
+      next_base = best_pos + best_len
+      t += best_len
+    else:
+      literal.append(target[t])
+      t += 1
+
+  flush_literal()
+  out.append(OP_END)
+  return bytes(out)
+
+
+# Rebuilds the target image, exactly as OTAHelper does on the device
+def apply_delta(base, delta):
+  if len(delta) < HEADER.size:
+    raise ValueError("truncated delta")
+  magic, version, base_size, base_md5, target_size, target_md5 = HEADER.unpack_from(delta, 0)
+  if magic != MAGIC or version != VERSION:
+    raise ValueError("not a delta file")
+  if base_size != len(base) or base_md5 != hashlib.md5(base).digest():
+    raise ValueError("delta is for a different base image")
+
+  target = bytearray()
+  pos = HEADER.size
+
+  def need(count):
+    if pos + count > len(delta):
+      raise ValueError("truncated delta")
+
+  while True:
+    need(1)
+    op = delta[pos]
+    pos += 1
+    if op == OP_END:
+      break
+    elif op == OP_COPY:
+      need(8)
+      offset, length = struct.unpack_from("<II", delta, pos)
+      pos += 8
+      if offset + length > len(base):
+        raise ValueError("copy past the end of the base image")
+      target.extend(base[offset:offset + length])
+    elif op == OP_DATA:
+      need(4)
+      (length,) = struct.unpack_from("<I", delta, pos)
+      pos += 4
+      need(length)
+      target.extend(delta[pos:pos + length])
+      pos += length
+    else:
+      raise ValueError("bad opcode 0x%02x at %d" % (op, pos - 1))
+
+  if pos != len(delta):
+    raise ValueError("data after the end marker")
+  if len(target) != target_size or hashlib.md5(target).digest() != target_md5:
+    raise ValueError("rebuilt image does not match")
+  return bytes(target)
+
+
+# Makes a delta, and refuses to hand it out unless it rebuilds the target exactly
+def make_verified_delta(base, target):
+  delta = make_delta(base, target)
+  if apply_delta(base, delta) != target:
+    raise ValueError("delta round trip failed")
+  return delta
+
+
+def read_file(path):
+  with open(path, "rb") as f:
+    return f.read()
+
+
+def write_file(path, data):
+  with open(path, "wb") as f:
+    f.write(data)
+
+
+def publish(update_name, new_path, out_dir, old_paths):
+  target = read_file(new_path)
+  update_dir = os.path.join(out_dir, update_name)
+  os.makedirs(update_dir, exist_ok=True)
+
+  full = gzip.compress(target, 9, mtime=0)
+  write_file(os.path.join(update_dir, "firmware.bin.gz"), full)
+  print("firmware.bin.gz  %7d bytes (%d%% of %d)" % (len(full), 100 * len(full) // len(target), len(target)))
+
+  for old_path in old_paths:
+    base = read_file(old_path)
+    delta = make_verified_delta(base, target)
+    name = hashlib.md5(base).hexdigest() + ".hdlt"
+    write_file(os.path.join(update_dir, name), delta)
+    print("%s %7d bytes (%d%%) from %s" % (name, len(delta), 100 * len(delta) // len(target), old_path))
+
+  # Written last, so nodes never see a manifest before its files are in place
+  manifest = "target %s\nfull %s\n" % (hashlib.md5(target).hexdigest(), hashlib.md5(full).hexdigest())
+  write_file(os.path.join(update_dir, "manifest.txt.tmp"), manifest.encode())
+  os.replace(os.path.join(update_dir, "manifest.txt.tmp"), os.path.join(update_dir, "manifest.txt"))
+
+
+def main(argv):
+  if len(argv) == 5 and argv[1] == "make":
+    base, target = read_file(argv[2]), read_file(argv[3])
+    delta = make_verified_delta(base, target)
+    write_file(argv[4], delta)
+    print("%d bytes (%d%% of %d)" % (len(delta), 100 * len(delta) // len(target), len(target)))
+  elif len(argv) == 5 and argv[1] == "apply":
+    write_file(argv[4], apply_delta(read_file(argv[2]), read_file(argv[3])))
+  elif len(argv) >= 5 and argv[1] == "publish":
+    publish(argv[2], argv[3], argv[4], argv[5:])
+  else:
+    sys.stderr.write("usage: ota_delta.py make <old.bin> <new.bin> <out.hdlt>\n"
+                     "       ota_delta.py apply <old.bin> <in.hdlt> <out.bin>\n"
+                     "       ota_delta.py publish <name> <new.bin> <dir> [old.bin ...]\n")
+    return 2
+  return 0
+
+
+if __name__ == "__main__":
+  try:
+    sys.exit(main(sys.argv))
+  except (OSError, ValueError) as e:
+    sys.stderr.write("ota_delta.py: %s\n" % e)
+    sys.exit(1)
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+#----------------------------------------------------------------------------------------------------------------
+# test_ota_delta.py
+#
+# Checks ota_delta.py round trips, rejects bad input, and writes the exact layout OTAHelper parses.
+#
+#   python3 tools/test_ota_delta.py
+#
+# Author - Joshua Villwock
+# Created - 2026-10-19
+# License - Mozilla Public License 2.0 (Do what you want, credit the author, must release under same license)
+#----------------------------------------------------------------------------------------------------------------
+
+import hashlib
+import os
+import random
+import struct
+import sys
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import ota_delta
+
+
+# Firmware-ish filler: random, so only real matches are found, and repeatable between runs
+def image(size, seed):
+  rng = random.Random(seed)
+  return bytes(rng.getrandbits(8) for _ in range(size))
+
+
+# Splits a delta body into (op, args) tuples, without going through apply_delta
+def ops(delta):
+  result = []
+  pos = ota_delta.HEADER.size
+  while True:
+    op = delta[pos]
+    pos += 1
+    if op == ota_delta.OP_END:
+      result.append((op,))
+      return result
+    elif op == ota_delta.OP_COPY:
+      result.append((op,) + struct.unpack_from("<II", delta, pos))
+      pos += 8
+    else:
+      (length,) = struct.unpack_from("<I", delta, pos)
+      result.append((op, delta[pos + 4:pos + 4 + length]))
+      pos += 4 + length
+
+
+class RoundTrip(unittest.TestCase):
+
+  def round_trip(self, base, target):
+    delta = ota_delta.make_delta(base, target)
+    self.assertEqual(ota_delta.apply_delta(base, delta), target)
+    return delta
+
+  def test_identical(self):
+    base = image(4096, 1)
+    delta = self.round_trip(base, base)
+    self.assertEqual(ops(delta), [(ota_delta.OP_COPY, 0, len(base)), (ota_delta.OP_END,)])
+
+  def test_insertion(self):
+    base = image(4096, 2)
+    target = base[:1000] + b"new code here" * 10 + base[1000:]
+    delta = self.round_trip(base, target)
+    self.assertLess(len(delta), ota_delta.HEADER.size + 200)
+
+  def test_deletion(self):
+    base = image(4096, 3)
+    target = base[:1000] + base[1500:]
+    delta = self.round_trip(base, target)
+    self.assertEqual(ops(delta), [(ota_delta.OP_COPY, 0, 1000), (ota_delta.OP_COPY, 1500, 2596),
+                                  (ota_delta.OP_END,)])
+
+  def test_block_move(self):
+    blocks = [image(1024, seed) for seed in range(10, 14)]
+    base = b"".join(blocks)
+    target = blocks[2] + blocks[0] + blocks[3] + blocks[1]
+    delta = self.round_trip(base, target)
+    self.assertEqual([op for op in ops(delta) if op[0] == ota_delta.OP_DATA], [])
+
+  def test_empty_base(self):
+    target = image(500, 4)
+    delta = self.round_trip(b"", target)
+    self.assertEqual(ops(delta), [(ota_delta.OP_DATA, target), (ota_delta.OP_END,)])
+
+  def test_empty_target(self):
+    self.round_trip(image(500, 5), b"")
+
+
+class BadInput(unittest.TestCase):
+
+  def setUp(self):
+    self.base = image(2048, 6)
+    self.target = self.base[:700] + b"changed" + self.base[900:]
+    self.delta = ota_delta.make_delta(self.base, self.target)
+
+  def test_truncated(self):
+    for length in range(len(self.delta)):
+      with self.assertRaises(ValueError, msg="cut at %d" % length):
+        ota_delta.apply_delta(self.base, self.delta[:length])
+
+  def test_data_after_end(self):
+    with self.assertRaises(ValueError):
+      ota_delta.apply_delta(self.base, self.delta + b"\x00")
+
+  def test_wrong_base(self):
+    other = bytearray(self.base)
+    other[5] ^= 0xFF
+    with self.assertRaisesRegex(ValueError, "different base"):
+      ota_delta.apply_delta(bytes(other), self.delta)
+    with self.assertRaisesRegex(ValueError, "different base"):
+      ota_delta.apply_delta(self.base[:-1], self.delta)
+
+  def test_bad_opcode(self):
+    delta = self.delta[:ota_delta.HEADER.size] + b"\x07"
+    with self.assertRaisesRegex(ValueError, "bad opcode 0x07 at %d" % ota_delta.HEADER.size):
+      ota_delta.apply_delta(self.base, delta)
+
+  def test_bad_magic(self):
+    with self.assertRaisesRegex(ValueError, "not a delta"):
+      ota_delta.apply_delta(self.base, b"XDLT" + self.delta[4:])
+
+  def test_copy_past_base(self):
+    delta = self.delta[:ota_delta.HEADER.size] + struct.pack("<BII", ota_delta.OP_COPY, 2000, 100) + b"\x00"
+    with self.assertRaisesRegex(ValueError, "past the end"):
+      ota_delta.apply_delta(self.base, delta)
+
+
+# OTAHelper reads these bytes by offset, so the layout is checked byte for byte rather than via HEADER
+class Layout(unittest.TestCase):
+
+  def test_header(self):
+    base = image(300, 7)
+    target = base[:100] + b"x" + base[100:]
+    delta = ota_delta.make_delta(base, target)
+    self.assertEqual(ota_delta.HEADER.size, 48)
+    self.assertEqual(delta[0:4], b"HDLT")
+    self.assertEqual(delta[4], 1)
+    self.assertEqual(delta[5:8], b"\x00\x00\x00")
+    self.assertEqual(delta[8:12], len(base).to_bytes(4, "little"))
+    self.assertEqual(delta[12:28], hashlib.md5(base).digest())
+    self.assertEqual(delta[28:32], len(target).to_bytes(4, "little"))
+    self.assertEqual(delta[32:48], hashlib.md5(target).digest())
+
+  def test_ops(self):
+    base = image(300, 8)
+    target = base[50:200] + b"abc"
+    delta = ota_delta.make_delta(base, target)
+    body = delta[48:]
+    self.assertEqual(body[0], 0x01)                                 # COPY
+    self.assertEqual(body[1:5], (50).to_bytes(4, "little"))         # offset first
+    self.assertEqual(body[5:9], (150).to_bytes(4, "little"))        # then length
+    self.assertEqual(body[9], 0x02)                                 # DATA
+    self.assertEqual(body[10:14], (3).to_bytes(4, "little"))        # length
+    self.assertEqual(body[14:17], b"abc")                           # literal bytes
+    self.assertEqual(body[17:], b"\x00")                            # END, and nothing after
+
+
+if __name__ == "__main__":
+  unittest.main()